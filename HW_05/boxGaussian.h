@@ -0,0 +1,156 @@
+/*************************************************************************************************************
+* Frequency Domain Processing
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Box Gaussian: approximation of a Gaussian blur by a cascade of 3 to 5 box filters (central limit theorem)
+*
+* The widths are the odd pair wl, wl + 2 whose mix gives the variance closest to sigma^2 of the Gaussian
+* (Kovesi, "Fast almost-Gaussian filtering"); boxSigma() reports the one achieved. Each box is a running sum: one add and one subtract per pixel
+* whatever its width. As in recursiveGaussian.h, the sums run down the columns a whole row at a time
+* (vectorized across columns), strips of columns go to different threads and the horizontal boxes are the
+* vertical ones on the transposed image. Borders are replicated.
+**************************************************************************************************************/
+
+#ifndef _BOX_GAUSSIAN_H_
+#define _BOX_GAUSSIAN_H_
+
+#include <opencv2/core/core.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define BOX_PASSES      3           // Default number of boxes in the cascade
+#define BOX_MAX_PASSES  5
+#define BOX_STRIP_WIDTH 64          // Columns per parallel job (a multiple of the vector width)
+
+// Odd widths of the boxes whose cascade has the variance closest to sigma^2
+inline std::vector<int> boxWidths(double sigma, int passes)
+{
+  double ideal = std::sqrt(12.0 * sigma * sigma / passes + 1.0);
+  int wl = (int)std::floor(ideal);
+  if(wl % 2 == 0)
+    wl--;
+  wl = std::max(wl, 1);
+  int m = (int)std::floor((12.0 * sigma * sigma - passes * wl * wl - 4.0 * passes * wl - 3.0 * passes)
+                          / (-4.0 * wl - 4.0) + 0.5);
+  m = std::max(0, std::min(m, passes));
+  std::vector<int> widths(passes, wl + 2);
+  std::fill(widths.begin(), widths.begin() + m, wl);
+  return widths;
+}
+
+// Standard deviation of the cascade: a box of width w has variance (w^2 - 1) / 12
+inline double boxSigma(const std::vector<int> &widths)
+{
+  double variance = 0;
+  for(size_t p = 0; p < widths.size(); p++)
+    variance += (widths[p] * widths[p] - 1) / 12.0;
+  return std::sqrt(variance);
+}
+
+// out[x] = sum[x] * scale, then sum[x] += add[x] - sub[x], for x in [0, n)
+inline void boxRow(float *out, float *sum, const float *add, const float *sub, int n, float scale)
+{
+  int x = 0;
+#if defined(__ARM_NEON)
+  float32x4_t s = vdupq_n_f32(scale);
+  for(; x + 4 <= n; x += 4)
+  {
+    float32x4_t acc = vld1q_f32(sum + x);
+    vst1q_f32(out + x, vmulq_f32(acc, s));
+    vst1q_f32(sum + x, vaddq_f32(acc, vsubq_f32(vld1q_f32(add + x), vld1q_f32(sub + x))));
+  }
+#elif defined(__SSE2__)
+  __m128 s = _mm_set1_ps(scale);
+  for(; x + 4 <= n; x += 4)
+  {
+    __m128 acc = _mm_loadu_ps(sum + x);
+    _mm_storeu_ps(out + x, _mm_mul_ps(acc, s));
+    _mm_storeu_ps(sum + x, _mm_add_ps(acc, _mm_sub_ps(_mm_loadu_ps(add + x), _mm_loadu_ps(sub + x))));
+  }
+#endif
+  for(; x < n; x++)
+  {
+    out[x] = sum[x] * scale;
+    sum[x] += add[x] - sub[x];
+  }
+}
+
+// Vertical box of the given odd width over the columns [x0, x1): src to dst (different images)
+inline void boxColumns(const cv::Mat &src, cv::Mat &dst, int x0, int x1, int width, std::vector<float> &sum)
+{
+  const int rows = src.rows;
+  const int n = x1 - x0;
+  const int r = width / 2;
+  std::fill(sum.begin(), sum.begin() + n, 0.0f);
+  for(int k = -r; k <= r; k++)
+  {
+    const float *in = src.ptr<float>(std::max(0, std::min(k, rows - 1))) + x0;
+    for(int x = 0; x < n; x++)
+      sum[x] += in[x];
+  }
+  for(int y = 0; y < rows; y++)
+    boxRow(dst.ptr<float>(y) + x0, &sum[0], src.ptr<float>(std::min(y + r + 1, rows - 1)) + x0,
+           src.ptr<float>(std::max(y - r, 0)) + x0, n, 1.0f / width);
+}
+
+class boxColumnsBody : public cv::ParallelLoopBody
+{
+public:
+  boxColumnsBody(cv::Mat &data, cv::Mat &scratch, const std::vector<int> &widths)
+    : data_(data), scratch_(scratch), widths_(widths) {}
+
+  // Every strip runs the whole cascade on its own columns: no synchronization between the boxes
+  void operator()(const cv::Range &range) const
+  {
+    int x0 = range.start * BOX_STRIP_WIDTH;
+    int x1 = std::min(range.end * BOX_STRIP_WIDTH, data_.cols);
+    std::vector<float> sum(x1 - x0);
+    cv::Mat *from = &data_, *to = &scratch_;
+    for(size_t p = 0; p < widths_.size(); p++)
+    {
+      boxColumns(*from, *to, x0, x1, widths_[p], sum);
+      std::swap(from, to);
+    }
+    if(from != &data_)
+      for(int y = 0; y < data_.rows; y++)
+        std::copy(from->ptr<float>(y) + x0, from->ptr<float>(y) + x1, data_.ptr<float>(y) + x0);
+  }
+
+private:
+  cv::Mat &data_;
+  cv::Mat &scratch_;
+  const std::vector<int> &widths_;
+};
+
+// Vertical cascade over all the columns of a CV_32F image, in place
+inline void boxVertical(cv::Mat &data, const std::vector<int> &widths)
+{
+  cv::Mat scratch(data.size(), CV_32F);
+  int strips = (data.cols + BOX_STRIP_WIDTH - 1) / BOX_STRIP_WIDTH;
+  cv::parallel_for_(cv::Range(0, strips), boxColumnsBody(data, scratch, widths));
+}
+
+// Gaussian blur of standard deviation sigma approximated by passes (3 to 5) boxes; dst has the type of src
+inline void boxGaussian(const cv::Mat &src, cv::Mat &dst, double sigma, int passes = BOX_PASSES)
+{
+  std::vector<int> widths = boxWidths(sigma, std::max(1, std::min(passes, BOX_MAX_PASSES)));
+  cv::Mat data, transposed;
+  src.convertTo(data, CV_32F);
+  boxVertical(data, widths);
+  cv::transpose(data, transposed);
+  boxVertical(transposed, widths);
+  cv::transpose(transposed, data);
+  data.convertTo(dst, src.type());
+}
+
+#endif
@@ -0,0 +1,227 @@
+/*************************************************************************************************************
+* Frequency Domain Processing
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Convolve: one entry point that picks the fastest of filter2D, sepFilter2D and overlap-save FFT filtering
+*
+* A kernel is separable when it has rank one: its SVD then gives the column and row factors. The cost of
+* each route comes from a per-machine model built with the kernel size sweep of tarea05: the measured time
+* per pixel at each kernel size (averaged over the runs), interpolated linearly in between (and extended
+* flat beyond the ends). Interpolating measurements instead of fitting operation counts keeps the model
+* right where a route changes algorithm internally (filter2D switches to a DFT for large kernels). Without
+* a calibration the routes are ranked by operation counts. Every route returns what filter2D would
+* (BORDER_DEFAULT, centered anchor). What depends only on the kernel (its rank-one factors and its tile
+* spectrum) is cached under a digest of the kernel values, so repeated calls with the same kernel skip the
+* SVD and the transform.
+**************************************************************************************************************/
+
+#ifndef _CONVOLVE_H_
+#define _CONVOLVE_H_
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include "overlapSave.h"
+#include "spectrumCache.h"
+
+#include <stdint.h>
+
+#define SEPARABLE_TOLERANCE 1e-6    // Second singular value relative to the first, below which rank is one
+
+enum convolveRoute
+{
+  RouteDirect2D = 0,                // filter2D with the full kernel
+  RouteSeparable,                   // sepFilter2D with the rank-one factors
+  RouteOverlapSave,                 // FFT in tiles (overlapSave.h)
+  NUM_ROUTES
+};
+
+inline const char *routeName(convolveRoute route)
+{
+  static const char *names[NUM_ROUTES] = { "filter2D", "sepFilter2D", "overlap-save" };
+  return names[route];
+}
+
+// Rank-one factors of kernel (kernel = column * row), if it has rank one
+inline bool separableFactors(const cv::Mat &kernel, cv::Mat &column, cv::Mat &row)
+{
+  cv::Mat k, w, u, vt;
+  kernel.convertTo(k, CV_64F);
+  cv::SVD::compute(k, w, u, vt);
+  double first = w.at<double>(0);
+  if(first <= 0 || (w.rows > 1 && w.at<double>(1) > SEPARABLE_TOLERANCE * first))
+    return false;
+  double scale = std::sqrt(first);
+  cv::Mat(u.col(0) * scale).convertTo(column, CV_32F);
+  cv::Mat(vt.row(0) * scale).convertTo(row, CV_32F);
+  return true;
+}
+
+// FNV-1a digest of the kernel values (as floats), in hexadecimal: the cache key of kernel-derived data
+inline std::string kernelDigest(const cv::Mat &kernel)
+{
+  cv::Mat k;
+  kernel.convertTo(k, CV_32F);
+  uint64_t hash = 14695981039346656037ull;
+  for(int y = 0; y < k.rows; y++)
+  {
+    const uint8_t *bytes = k.ptr<uint8_t>(y);
+    for(size_t i = 0; i < k.cols * sizeof(float); i++)
+      hash = (hash ^ bytes[i]) * 1099511628211ull;
+  }
+  char digest[17];
+  snprintf(digest, sizeof(digest), "%016llx", (unsigned long long)hash);
+  return digest;
+}
+
+/*
+ * Rank-one factors of the kernel from cache: the column factor followed by the row factor in one row, or
+ * an empty Mat when the kernel is not separable. The SVD runs only the first time a kernel is seen.
+ */
+inline cv::Mat cachedFactors(const cv::Mat &kernel, const std::string &digest, spectrumCache &cache)
+{
+  spectrumKey key = { "rank1/" + digest, std::max(kernel.rows, kernel.cols), 0, kernel.rows, kernel.cols };
+  return cache.get(key, [&]()
+  {
+    cv::Mat column, row, factors;
+    if(separableFactors(kernel, column, row))
+    {
+      factors.create(1, kernel.rows + kernel.cols, CV_32F);
+      column.reshape(1, 1).copyTo(factors.colRange(0, kernel.rows));
+      row.reshape(1, 1).copyTo(factors.colRange(kernel.rows, kernel.rows + kernel.cols));
+    }
+    return factors;
+  });
+}
+
+/*
+ * Seconds per pixel of every route as a function of the kernel size. Non-square kernels use the side of
+ * the square with the same work: sqrt(kh * kw) for the 2D routes, (kh + kw) / 2 for the separable one.
+ */
+class convolveModel
+{
+public:
+  // Running mean of the measurements of route at ksize; weight is how many measurements the sample averages
+  void addSample(convolveRoute route, int ksize, double secondsPerPixel, int weight = 1)
+  {
+    int &count = counts_[route][ksize];
+    double &mean = samples_[route][ksize];
+    mean = (mean * count + secondsPerPixel * weight) / (count + weight);
+    count += weight;
+  }
+
+  bool calibrated() const
+  {
+    for(int r = 0; r < NUM_ROUTES; r++)
+      if(samples_[r].empty())
+        return false;
+    return true;
+  }
+
+  // Estimated seconds to filter pixels pixels with a kh x kw kernel through route
+  double cost(convolveRoute route, int kh, int kw, double pixels) const
+  {
+    double ksize = (route == RouteSeparable) ? (kh + kw) / 2.0 : std::sqrt((double)kh * kw);
+    if(calibrated())
+      return pixels * interpolate(samples_[route], ksize);
+
+    // Operation counts per pixel
+    if(route == RouteDirect2D)
+      return pixels * kh * kw;
+    if(route == RouteSeparable)
+      return pixels * (kh + kw);
+    int tile = overlapTileSize(std::max(kh, kw));
+    double valid = tile - std::max(kh, kw) + 1;
+    return pixels * (double)tile * tile * std::log2((double)tile * tile) / (valid * valid);
+  }
+
+  // Cheapest route for the kernel; separable only when it has rank one
+  convolveRoute choose(int kh, int kw, double pixels, bool separable) const
+  {
+    convolveRoute best = RouteDirect2D;
+    for(int r = RouteSeparable; r < NUM_ROUTES; r++)
+    {
+      if(r == RouteSeparable && !separable)
+        continue;
+      if(cost((convolveRoute)r, kh, kw, pixels) < cost(best, kh, kw, pixels))
+        best = (convolveRoute)r;
+    }
+    return best;
+  }
+
+  // One "route ksize secondsPerPixel measurements" line per sample
+  bool save(const std::string &path) const
+  {
+    std::ofstream out(path.c_str());
+    for(int r = 0; r < NUM_ROUTES; r++)
+      for(std::map<int, double>::const_iterator s = samples_[r].begin(); s != samples_[r].end(); ++s)
+        out << r << " " << s->first << " " << s->second << " " << counts_[r].at(s->first) << std::endl;
+    return (bool)out;
+  }
+
+  // Merges the samples of a saved model into this one (running means), so calibrations accumulate
+  bool load(const std::string &path)
+  {
+    std::ifstream in(path.c_str());
+    int route, ksize, count;
+    double seconds;
+    while(in >> route >> ksize >> seconds >> count)
+      if(route >= 0 && route < NUM_ROUTES && count > 0)
+        addSample((convolveRoute)route, ksize, seconds, count);
+    return calibrated();
+  }
+
+private:
+  static double interpolate(const std::map<int, double> &samples, double ksize)
+  {
+    std::map<int, double>::const_iterator above = samples.lower_bound((int)std::ceil(ksize));
+    if(above == samples.begin())
+      return above->second;
+    if(above == samples.end())
+      return samples.rbegin()->second;
+    std::map<int, double>::const_iterator below = above;
+    --below;
+    double t = (ksize - below->first) / (above->first - below->first);
+    return below->second + t * (above->second - below->second);
+  }
+
+  std::map<int, double> samples_[NUM_ROUTES];
+  std::map<int, int> counts_[NUM_ROUTES];   // Measurements behind each sample
+};
+
+/*
+ * dst = filter2D(src, -1, kernel) through the route the model says is cheapest; returns that route. The
+ * separability test and the overlap-save spectrum are cached under the digest of the kernel values.
+ */
+inline convolveRoute convolve(const cv::Mat &src, cv::Mat &dst, const cv::Mat &kernel,
+                              const convolveModel &model, spectrumCache &cache)
+{
+  std::string digest = kernelDigest(kernel);
+  cv::Mat factors = cachedFactors(kernel, digest, cache);
+  convolveRoute route = model.choose(kernel.rows, kernel.cols, (double)src.total(), !factors.empty());
+  switch(route)
+  {
+    case RouteSeparable:
+      cv::sepFilter2D(src, dst, -1, factors.colRange(kernel.rows, kernel.rows + kernel.cols),
+                      factors.colRange(0, kernel.rows), cv::Point(-1, -1), 0, cv::BORDER_DEFAULT);
+      break;
+    case RouteOverlapSave:
+      overlapSaveFilter(src, dst, kernel, cache, "kernel/" + digest, 0);
+      break;
+    default:
+      cv::filter2D(src, dst, -1, kernel, cv::Point(-1, -1), 0, cv::BORDER_DEFAULT);
+      break;
+  }
+  return route;
+}
+
+#endif
@@ -0,0 +1,78 @@
+/*************************************************************************************************************
+* Frequency Domain Processing
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Filter Bank: one image through N kernels (scale spaces, feature extractors) for one forward transform
+*
+* The caller transforms the image once; every kernel then only costs its spectrum product and inverse
+* transform. Those are independent, so the kernels are split in one stripe per worker thread, and each
+* stripe runs its kernels one after the other through its own frequencyFilter. Only those few product
+* buffers (one padded float plane each, whatever the number of kernels) and the 8-bit outputs are kept in
+* the bank and reused from one image to the next.
+**************************************************************************************************************/
+
+#ifndef _FILTER_BANK_H_
+#define _FILTER_BANK_H_
+
+#include <opencv2/core/core.hpp>
+#include <algorithm>
+#include <vector>
+
+#include "frequencyFilter.h"
+
+class filterBankBody : public cv::ParallelLoopBody
+{
+public:
+  filterBankBody(const cv::Mat &imageSpectrum, const std::vector<cv::Mat> &kernelSpectra, cv::Size imageSize,
+                 std::vector<frequencyFilter> &engines, std::vector<cv::Mat> &outputs)
+    : imageSpectrum_(imageSpectrum), kernelSpectra_(kernelSpectra), imageSize_(imageSize), engines_(engines),
+      outputs_(outputs) {}
+
+  // Kernels [s n / stripes, (s + 1) n / stripes) of every stripe s in range, through engine s
+  void operator()(const cv::Range &range) const
+  {
+    const int n = (int)kernelSpectra_.size();
+    const int stripes = (int)engines_.size();
+    for(int s = range.start; s < range.end; s++)
+      for(int k = s * n / stripes; k < (s + 1) * n / stripes; k++)
+        engines_[s].apply(imageSpectrum_, kernelSpectra_[k], imageSize_, outputs_[k]);
+  }
+
+private:
+  const cv::Mat &imageSpectrum_;
+  const std::vector<cv::Mat> &kernelSpectra_;
+  cv::Size imageSize_;
+  std::vector<frequencyFilter> &engines_;
+  std::vector<cv::Mat> &outputs_;
+};
+
+class filterBank
+{
+public:
+  /*
+   * Filters the image of the given size, whose packed spectrum is imageSpectrum, by every kernel spectrum
+   * (same padded size, centers at the origin, as cached by the spectrumCache). Output k is the image
+   * filtered by kernel k, valid until the next call.
+   */
+  const std::vector<cv::Mat> &apply(const cv::Mat &imageSpectrum, const std::vector<cv::Mat> &kernelSpectra,
+                                    cv::Size imageSize)
+  {
+    int stripes = std::max(1, std::min(cv::getNumThreads(), (int)kernelSpectra.size()));
+    engines_.resize(stripes);
+    outputs_.resize(kernelSpectra.size());
+    cv::parallel_for_(cv::Range(0, stripes),
+                      filterBankBody(imageSpectrum, kernelSpectra, imageSize, engines_, outputs_), stripes);
+    return outputs_;
+  }
+
+  const std::vector<cv::Mat> &outputs() const { return outputs_; }
+
+private:
+  std::vector<frequencyFilter> engines_;    // One product buffer per stripe (worker thread)
+  std::vector<cv::Mat> outputs_;
+};
+
+#endif
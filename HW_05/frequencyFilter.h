@@ -0,0 +1,40 @@
+/*************************************************************************************************************
+* Frequency Domain Processing
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Frequency Filter: spectrum product, inverse transform and conversion to 8 bits with no temporaries
+*
+* The product of the packed (CCS) spectra goes into a buffer that is kept between frames, the inverse
+* transform runs in place on it and computes only the rows of the image (not the padding), and the 1/(M N)
+* scale of the unnormalized inverse is applied by the same pass that saturates to 8 bits into the caller's
+* output. After the first frame of a given size nothing is allocated.
+**************************************************************************************************************/
+
+#ifndef _FREQUENCY_FILTER_H_
+#define _FREQUENCY_FILTER_H_
+
+#include <opencv2/core/core.hpp>
+
+class frequencyFilter
+{
+public:
+  /*
+   * dst (imageSize, CV_8U) = image filtered by kernel, both spectra packed and of the same padded size.
+   * The kernel is expected with its center at the origin and unit sum, so no normalization is needed.
+   */
+  void apply(const cv::Mat &imageSpectrum, const cv::Mat &kernelSpectrum, cv::Size imageSize, cv::Mat &dst)
+  {
+    cv::mulSpectrums(imageSpectrum, kernelSpectrum, product_, 0);                 // Reuses product_
+    cv::dft(product_, product_, cv::DFT_INVERSE | cv::DFT_REAL_OUTPUT, imageSize.height);
+    double scale = 1.0 / ((double)product_.rows * product_.cols);
+    product_(cv::Rect(0, 0, imageSize.width, imageSize.height)).convertTo(dst, CV_8U, scale);
+  }
+
+private:
+  cv::Mat product_;                 // Spectrum product, then the real inverse in place
+};
+
+#endif
@@ -0,0 +1,206 @@
+/*************************************************************************************************************
+* Frequency Domain Processing
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Image Metrics: MSE, PSNR and SSIM of two 8-bit images, used to validate the fast approximations
+*
+* The squared error is a single pass over both images: |a - b| on 16 bytes at a time, squared and summed in
+* 32-bit lanes (NEON or SSE2, plain C++ otherwise), one 64-bit total per band of rows and the bands on
+* different threads. SSIM (Wang et al., 11 x 11 Gaussian window of sigma 1.5) fuses the five local
+* statistics: x, y, x^2, y^2 and xy are written in one pass as a five channel image, blurred by a single
+* GaussianBlur, and the SSIM map is reduced in a last pass without being stored.
+**************************************************************************************************************/
+
+#ifndef _IMAGE_METRICS_H_
+#define _IMAGE_METRICS_H_
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <stdint.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define METRICS_BAND_ROWS 32        // Rows per parallel job
+#define METRICS_CHUNK     4096      // Bytes summed in 32-bit lanes before moving them to the 64-bit total
+
+// Runs work(band) for every band of METRICS_BAND_ROWS rows out of rows, in parallel
+template<class Work>
+class metricsBandBody : public cv::ParallelLoopBody
+{
+public:
+  explicit metricsBandBody(const Work &work) : work_(work) {}
+  void operator()(const cv::Range &range) const
+  {
+    for(int band = range.start; band < range.end; band++)
+      work_(band);
+  }
+private:
+  Work work_;
+};
+
+template<class Work>
+inline int parallelBands(int rows, Work work)
+{
+  int bands = (rows + METRICS_BAND_ROWS - 1) / METRICS_BAND_ROWS;
+  cv::parallel_for_(cv::Range(0, bands), metricsBandBody<Work>(work));
+  return bands;
+}
+
+// Sum of (a[i] - b[i])^2 over n bytes
+inline uint64_t squaredDiffRow(const uint8_t *a, const uint8_t *b, int n)
+{
+  uint64_t total = 0;
+  int x = 0;
+  while(x + 16 <= n)
+  {
+    int end = std::min(n, x + METRICS_CHUNK) & ~15;
+    if(end <= x)
+      break;
+#if defined(__ARM_NEON)
+    uint32x4_t acc = vdupq_n_u32(0);
+    for(; x < end; x += 16)
+    {
+      uint8x16_t d = vabdq_u8(vld1q_u8(a + x), vld1q_u8(b + x));
+      acc = vpadalq_u16(acc, vmull_u8(vget_low_u8(d), vget_low_u8(d)));
+      acc = vpadalq_u16(acc, vmull_u8(vget_high_u8(d), vget_high_u8(d)));
+    }
+    total += (uint64_t)vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) + vgetq_lane_u32(acc, 2)
+             + vgetq_lane_u32(acc, 3);
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    for(; x < end; x += 16)
+    {
+      __m128i va = _mm_loadu_si128((const __m128i *)(a + x));
+      __m128i vb = _mm_loadu_si128((const __m128i *)(b + x));
+      __m128i d = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));      // |a - b|
+      __m128i lo = _mm_unpacklo_epi8(d, zero);
+      __m128i hi = _mm_unpackhi_epi8(d, zero);
+      acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+    }
+    uint32_t lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    total += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#else
+    break;
+#endif
+  }
+  for(; x < n; x++)
+  {
+    int d = (int)a[x] - (int)b[x];
+    total += (uint64_t)(d * d);
+  }
+  return total;
+}
+
+// Sum of squared differences of two 8-bit images of the same size and channels
+inline uint64_t getSSE(const cv::Mat &I1, const cv::Mat &I2)
+{
+  CV_Assert(I1.size() == I2.size() && I1.type() == I2.type() && I1.depth() == CV_8U);
+  const int rows = I1.rows;
+  const int bytes = I1.cols * I1.channels();
+  std::vector<uint64_t> partial((rows + METRICS_BAND_ROWS - 1) / METRICS_BAND_ROWS, 0);
+  parallelBands(rows, [&](int band)
+  {
+    int y1 = std::min(rows, (band + 1) * METRICS_BAND_ROWS);
+    for(int y = band * METRICS_BAND_ROWS; y < y1; y++)
+      partial[band] += squaredDiffRow(I1.ptr<uint8_t>(y), I2.ptr<uint8_t>(y), bytes);
+  });
+  uint64_t sse = 0;
+  for(size_t b = 0; b < partial.size(); b++)
+    sse += partial[b];
+  return sse;
+}
+
+inline double getMSE(const cv::Mat &I1, const cv::Mat &I2)
+{
+  return (double)getSSE(I1, I2) / ((double)I1.channels() * I1.total());
+}
+
+// PSNR in dB; 0 for identical images, as before
+inline double getPSNR(const cv::Mat &I1, const cv::Mat &I2)
+{
+  uint64_t sse = getSSE(I1, I2);
+  if(sse == 0)
+    return 0;
+  double mse = (double)sse / ((double)I1.channels() * I1.total());
+  return 10.0 * std::log10((255.0 * 255.0) / mse);
+}
+
+// Mean SSIM of two 8-bit images (averaged over the channels)
+inline double getMSSIM(const cv::Mat &I1, const cv::Mat &I2)
+{
+  CV_Assert(I1.size() == I2.size() && I1.type() == I2.type() && I1.depth() == CV_8U);
+  if(I1.channels() > 1)
+  {
+    std::vector<cv::Mat> planes1, planes2;
+    cv::split(I1, planes1);
+    cv::split(I2, planes2);
+    double mssim = 0;
+    for(size_t c = 0; c < planes1.size(); c++)
+      mssim += getMSSIM(planes1[c], planes2[c]);
+    return mssim / planes1.size();
+  }
+
+  const double C1 = 6.5025, C2 = 58.5225;   // (0.01 * 255)^2, (0.03 * 255)^2
+  const int rows = I1.rows;
+  const int cols = I1.cols;
+
+  // x, y, x^2, y^2, xy interleaved, then their local (Gaussian weighted) means
+  cv::Mat stats(rows, cols, CV_32FC(5));
+  parallelBands(rows, [&](int band)
+  {
+    int y1 = std::min(rows, (band + 1) * METRICS_BAND_ROWS);
+    for(int y = band * METRICS_BAND_ROWS; y < y1; y++)
+    {
+      const uint8_t *a = I1.ptr<uint8_t>(y);
+      const uint8_t *b = I2.ptr<uint8_t>(y);
+      float *s = stats.ptr<float>(y);
+      for(int x = 0; x < cols; x++, s += 5)
+      {
+        float fa = a[x], fb = b[x];
+        s[0] = fa;
+        s[1] = fb;
+        s[2] = fa * fa;
+        s[3] = fb * fb;
+        s[4] = fa * fb;
+      }
+    }
+  });
+  cv::GaussianBlur(stats, stats, cv::Size(11, 11), 1.5);
+
+  std::vector<double> partial((rows + METRICS_BAND_ROWS - 1) / METRICS_BAND_ROWS, 0.0);
+  parallelBands(rows, [&](int band)
+  {
+    int y1 = std::min(rows, (band + 1) * METRICS_BAND_ROWS);
+    double sum = 0;
+    for(int y = band * METRICS_BAND_ROWS; y < y1; y++)
+    {
+      const float *s = stats.ptr<float>(y);
+      for(int x = 0; x < cols; x++, s += 5)
+      {
+        double mx = s[0], my = s[1];
+        double vx = s[2] - mx * mx, vy = s[3] - my * my, cxy = s[4] - mx * my;
+        sum += ((2 * mx * my + C1) * (2 * cxy + C2)) / ((mx * mx + my * my + C1) * (vx + vy + C2));
+      }
+    }
+    partial[band] = sum;
+  });
+  double total = 0;
+  for(size_t b = 0; b < partial.size(); b++)
+    total += partial[b];
+  return total / ((double)rows * cols);
+}
+
+#endif
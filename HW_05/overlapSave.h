@@ -0,0 +1,133 @@
+/*************************************************************************************************************
+* Frequency Domain Processing
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Overlap-Save: FFT filtering in tiles instead of one transform of the whole (padded) image
+*
+* The image is bordered like filter2D (BORDER_DEFAULT) and cut into T x T tiles that overlap by the kernel
+* size minus one. Each tile is transformed, multiplied by the cached kernel spectrum of size T x T
+* (conjugated, which turns the circular convolution into the correlation filter2D computes) and transformed
+* back; its first T - k + 1 rows and columns are free of wrap-around and are stitched into the output. T is
+* picked from the kernel size and the cache size, so a tile and its spectrum stay in cache, and the tiles
+* run in parallel.
+**************************************************************************************************************/
+
+#ifndef _OVERLAP_SAVE_H_
+#define _OVERLAP_SAVE_H_
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "spectrumCache.h"
+
+#define OVERLAP_CACHE_BYTES (256 * 1024)   // Cache per core the tile buffers should fit in (L2)
+
+/*
+ * Tile side: among the sizes getOptimalDFTSize likes, the one with the lowest FFT cost per valid output
+ * pixel, T^2 log T / (T - k + 1)^2, up to the largest tile whose float buffer fits in half the cache (but
+ * always allowing tiles of twice the kernel size).
+ */
+inline int overlapTileSize(int ksize, size_t cacheBytes = OVERLAP_CACHE_BYTES)
+{
+  int fit = (int)std::sqrt(cacheBytes / 2.0 / sizeof(float));
+  int limit = std::max(fit, cv::getOptimalDFTSize(2 * ksize));
+  int best = cv::getOptimalDFTSize(2 * ksize);
+  double bestCost = 1e300;
+  for(int t = cv::getOptimalDFTSize(ksize + 1); t <= limit; t = cv::getOptimalDFTSize(t + 1))
+  {
+    double valid = t - ksize + 1;
+    double cost = (double)t * t * std::log((double)t) / (valid * valid);
+    if(cost < bestCost)
+    {
+      bestCost = cost;
+      best = t;
+    }
+  }
+  return best;
+}
+
+// Spectrum of the kernel at the top-left corner of a tile x tile plane (packed CCS)
+inline cv::Mat tileKernelSpectrum(const cv::Mat &kernel, int tile)
+{
+  cv::Mat spectrum = cv::Mat::zeros(tile, tile, CV_32F);
+  kernel.convertTo(spectrum(cv::Rect(0, 0, kernel.cols, kernel.rows)), CV_32F);
+  cv::dft(spectrum, spectrum);
+  return spectrum;
+}
+
+class overlapSaveBody : public cv::ParallelLoopBody
+{
+public:
+  overlapSaveBody(const cv::Mat &bordered, const cv::Mat &spectrum, cv::Mat &out, int tile, int step,
+                  int tilesPerRow)
+    : bordered_(bordered), spectrum_(spectrum), out_(out), tile_(tile), step_(step),
+      tilesPerRow_(tilesPerRow) {}
+
+  void operator()(const cv::Range &range) const
+  {
+    cv::Mat buffer(tile_, tile_, CV_32F);  // One per range of tiles, reused for each of them
+    for(int t = range.start; t < range.end; t++)
+    {
+      int y0 = (t / tilesPerRow_) * step_;
+      int x0 = (t % tilesPerRow_) * step_;
+      int h = std::min(tile_, bordered_.rows - y0);
+      int w = std::min(tile_, bordered_.cols - x0);
+      if(h < tile_ || w < tile_)
+        buffer = cv::Scalar::all(0);
+      bordered_(cv::Rect(x0, y0, w, h)).copyTo(buffer(cv::Rect(0, 0, w, h)));
+
+      cv::dft(buffer, buffer, 0, h);
+      cv::mulSpectrums(buffer, spectrum_, buffer, 0, true);
+      cv::dft(buffer, buffer, cv::DFT_INVERSE | cv::DFT_SCALE | cv::DFT_REAL_OUTPUT);
+
+      int validH = std::min(step_, out_.rows - y0);
+      int validW = std::min(step_, out_.cols - x0);
+      buffer(cv::Rect(0, 0, validW, validH)).copyTo(out_(cv::Rect(x0, y0, validW, validH)));
+    }
+  }
+
+private:
+  const cv::Mat &bordered_;
+  const cv::Mat &spectrum_;
+  cv::Mat &out_;
+  int tile_;
+  int step_;
+  int tilesPerRow_;
+};
+
+/*
+ * dst = filter2D(src, -1, kernel) through overlap-save. The kernel spectrum for the chosen tile size comes
+ * from cache, keyed on (kernelType + "/tile", kernel size, sigma, tile, tile).
+ */
+inline void overlapSaveFilter(const cv::Mat &src, cv::Mat &dst, const cv::Mat &kernel, spectrumCache &cache,
+                              const std::string &kernelType, double sigma)
+{
+  int ksize = std::max(kernel.rows, kernel.cols);
+  int tile = overlapTileSize(ksize);
+  int step = tile - ksize + 1;
+
+  spectrumKey key = { kernelType + "/tile", ksize, sigma, tile, tile };  // Not the wrapped whole-image one
+  cv::Mat spectrum = cache.get(key, [&]() { return tileKernelSpectrum(kernel, tile); });
+
+  // Same anchor and border as filter2D with Point(-1, -1) and BORDER_DEFAULT
+  cv::Mat bordered, floatSrc;
+  src.convertTo(floatSrc, CV_32F);
+  int top = kernel.rows / 2, left = kernel.cols / 2;
+  cv::copyMakeBorder(floatSrc, bordered, top, kernel.rows - 1 - top, left, kernel.cols - 1 - left,
+                     cv::BORDER_DEFAULT);
+
+  cv::Mat out(src.size(), CV_32F);
+  int tilesPerRow = (src.cols + step - 1) / step;
+  int tilesPerCol = (src.rows + step - 1) / step;
+  cv::parallel_for_(cv::Range(0, tilesPerRow * tilesPerCol),
+                    overlapSaveBody(bordered, spectrum, out, tile, step, tilesPerRow));
+  out.convertTo(dst, src.type());
+}
+
+#endif
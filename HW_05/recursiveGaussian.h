@@ -0,0 +1,145 @@
+/*************************************************************************************************************
+* Frequency Domain Processing
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Recursive Gaussian: Young and van Vliet third order IIR approximation, same cost per pixel for any sigma
+*
+*   causal:     w[n] = B x[n] + (b1 w[n-1] + b2 w[n-2] + b3 w[n-3]) / b0
+*   anticausal: y[n] = B w[n] + (b1 y[n+1] + b2 y[n+2] + b3 y[n+3]) / b0
+*
+* The recursions run down the columns a whole row at a time, so the inner loop is vectorized across
+* columns (NEON or SSE, plain C++ otherwise) and the image is split in strips of columns, one per thread.
+* The horizontal pass is the same vertical pass on the transposed image. Both ends are taken as constant
+* (replicated border): for a constant signal the recursion is at rest, so w[-k] = x[0] and y[N-1+k] = w[N-1].
+**************************************************************************************************************/
+
+#ifndef _RECURSIVE_GAUSSIAN_H_
+#define _RECURSIVE_GAUSSIAN_H_
+
+#include <opencv2/core/core.hpp>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define IIR_STRIP_WIDTH 64          // Columns per parallel job (a multiple of the vector width)
+
+struct yvvCoefficients
+{
+  float B;                          // Gain of the input
+  float a1, a2, a3;                 // b1/b0, b2/b0, b3/b0: weights of the last three outputs
+};
+
+// Coefficients for sigma (Young and van Vliet, 1995)
+inline yvvCoefficients yvvFromSigma(double sigma)
+{
+  double q = (sigma >= 2.5) ? 0.98711 * sigma - 0.96330
+                            : 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma);
+  double q2 = q * q, q3 = q2 * q;
+  double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+  double b1 = 2.44413 * q + 2.85619 * q2 + 1.26661 * q3;
+  double b2 = -(1.4281 * q2 + 1.26661 * q3);
+  double b3 = 0.422205 * q3;
+  yvvCoefficients c;
+  c.B = (float)(1.0 - (b1 + b2 + b3) / b0);
+  c.a1 = (float)(b1 / b0);
+  c.a2 = (float)(b2 / b0);
+  c.a3 = (float)(b3 / b0);
+  return c;
+}
+
+// out[x] = B in[x] + a1 p1[x] + a2 p2[x] + a3 p3[x] for x in [0, n); out may be in
+inline void yvvRow(float *out, const float *in, const float *p1, const float *p2, const float *p3, int n,
+                   const yvvCoefficients &c)
+{
+  int x = 0;
+#if defined(__ARM_NEON)
+  float32x4_t B = vdupq_n_f32(c.B), a1 = vdupq_n_f32(c.a1), a2 = vdupq_n_f32(c.a2), a3 = vdupq_n_f32(c.a3);
+  for(; x + 4 <= n; x += 4)
+  {
+    float32x4_t r = vmulq_f32(B, vld1q_f32(in + x));
+    r = vmlaq_f32(r, a1, vld1q_f32(p1 + x));
+    r = vmlaq_f32(r, a2, vld1q_f32(p2 + x));
+    r = vmlaq_f32(r, a3, vld1q_f32(p3 + x));
+    vst1q_f32(out + x, r);
+  }
+#elif defined(__SSE2__)
+  __m128 B = _mm_set1_ps(c.B), a1 = _mm_set1_ps(c.a1), a2 = _mm_set1_ps(c.a2), a3 = _mm_set1_ps(c.a3);
+  for(; x + 4 <= n; x += 4)
+  {
+    __m128 r = _mm_mul_ps(B, _mm_loadu_ps(in + x));
+    r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_loadu_ps(p1 + x)));
+    r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_loadu_ps(p2 + x)));
+    r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_loadu_ps(p3 + x)));
+    _mm_storeu_ps(out + x, r);
+  }
+#endif
+  for(; x < n; x++)
+    out[x] = c.B * in[x] + c.a1 * p1[x] + c.a2 * p2[x] + c.a3 * p3[x];
+}
+
+// Causal then anticausal pass down the columns [x0, x1) of a CV_32F image, in place
+inline void yvvColumns(cv::Mat &data, int x0, int x1, const yvvCoefficients &c)
+{
+  const int rows = data.rows;
+  const int n = x1 - x0;
+  for(int y = 0; y < rows; y++)
+  {
+    float *row = data.ptr<float>(y) + x0;
+    yvvRow(row, row, data.ptr<float>(std::max(y - 1, 0)) + x0, data.ptr<float>(std::max(y - 2, 0)) + x0,
+           data.ptr<float>(std::max(y - 3, 0)) + x0, n, c);
+  }
+  for(int y = rows - 1; y >= 0; y--)
+  {
+    float *row = data.ptr<float>(y) + x0;
+    yvvRow(row, row, data.ptr<float>(std::min(y + 1, rows - 1)) + x0,
+           data.ptr<float>(std::min(y + 2, rows - 1)) + x0,
+           data.ptr<float>(std::min(y + 3, rows - 1)) + x0, n, c);
+  }
+}
+
+class yvvColumnsBody : public cv::ParallelLoopBody
+{
+public:
+  yvvColumnsBody(cv::Mat &data, const yvvCoefficients &c) : data_(data), c_(c) {}
+
+  void operator()(const cv::Range &range) const
+  {
+    int x0 = range.start * IIR_STRIP_WIDTH;
+    int x1 = std::min(range.end * IIR_STRIP_WIDTH, data_.cols);
+    yvvColumns(data_, x0, x1, c_);
+  }
+
+private:
+  cv::Mat &data_;
+  yvvCoefficients c_;
+};
+
+// Vertical pass over all the columns of a CV_32F image, strips of columns in parallel
+inline void yvvVertical(cv::Mat &data, const yvvCoefficients &c)
+{
+  int strips = (data.cols + IIR_STRIP_WIDTH - 1) / IIR_STRIP_WIDTH;
+  cv::parallel_for_(cv::Range(0, strips), yvvColumnsBody(data, c));
+}
+
+// Gaussian blur of standard deviation sigma; dst has the type of src
+inline void recursiveGaussian(const cv::Mat &src, cv::Mat &dst, double sigma)
+{
+  yvvCoefficients c = yvvFromSigma(sigma);
+  cv::Mat data, transposed;
+  src.convertTo(data, CV_32F);
+  yvvVertical(data, c);
+  cv::transpose(data, transposed);
+  yvvVertical(transposed, c);
+  cv::transpose(transposed, data);
+  data.convertTo(dst, src.type());
+}
+
+#endif
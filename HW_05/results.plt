@@ -4,4 +4,4 @@ set title "Gaussian Kernel Timing Results"
 set xlabel "Kernel Size"
 set ylabel "Time"
 set grid
-plot "data.dat" u (column(0)):2:xtic(1) w l title "Space-Unified","data.dat" u (column(0)):3:xtic(1) w l title "Space-Sep","data.dat" u (column(0)):4:xtic(1) w l title "Freq-Unified"
\ No newline at end of file
+plot "data.dat" u (column(0)):2:xtic(1) w l title "Space-Unified","data.dat" u (column(0)):3:xtic(1) w l title "Space-Sep","data.dat" u (column(0)):4:xtic(1) w l title "Freq-Unified","data.dat" u (column(0)):5:xtic(1) w l title "Freq-OverlapSave","data.dat" u (column(0)):6:xtic(1) w l title "Space-Recursive","data.dat" u (column(0)):7:xtic(1) w l title "Space-BoxCascade"
\ No newline at end of file
@@ -0,0 +1,127 @@
+/*************************************************************************************************************
+* Frequency Domain Processing
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Spectrum Cache: kernel spectra computed once and reused for every frame filtered with the same kernel
+*
+* Entries are keyed on (kernel type, size, sigma, padded rows and columns) and evicted in least recently
+* used order once their total size passes the byte limit. The returned Mat shares the cached data, so an
+* evicted spectrum stays valid for whoever still holds it.
+**************************************************************************************************************/
+
+#ifndef _SPECTRUM_CACHE_H_
+#define _SPECTRUM_CACHE_H_
+
+#include <opencv2/core/core.hpp>
+#include <iostream>
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+
+#define SPECTRUM_CACHE_BYTES (256 << 20)   // Default limit: 256 MB of spectra
+
+struct spectrumKey
+{
+  std::string type;                 // "gaussian", ...
+  int ksize;
+  double sigma;
+  int rows;                         // Padded (DFT) size
+  int cols;
+
+  bool operator<(const spectrumKey &other) const
+  {
+    if(type != other.type) return type < other.type;
+    if(ksize != other.ksize) return ksize < other.ksize;
+    if(sigma != other.sigma) return sigma < other.sigma;
+    if(rows != other.rows) return rows < other.rows;
+    return cols < other.cols;
+  }
+};
+
+class spectrumCache
+{
+public:
+  explicit spectrumCache(size_t maxBytes = SPECTRUM_CACHE_BYTES)
+    : maxBytes_(maxBytes), bytes_(0), hits_(0), misses_(0), evictions_(0) {}
+
+  // The spectrum of key, computed with build() (any callable returning a Mat) only on a miss
+  template<class Build>
+  cv::Mat get(const spectrumKey &key, Build build)
+  {
+    std::map<spectrumKey, entryList::iterator>::iterator found = index_.find(key);
+    if(found != index_.end())
+    {
+      hits_++;
+      entries_.splice(entries_.begin(), entries_, found->second);    // Most recently used first
+      return found->second->second;
+    }
+
+    misses_++;
+    cv::Mat spectrum = build();
+    entries_.push_front(std::make_pair(key, spectrum));
+    index_[key] = entries_.begin();
+    bytes_ += sizeOf(spectrum);
+    evict();
+    return spectrum;
+  }
+
+  // Changes the byte limit (e.g. once the padded size of the workload is known), evicting if it shrinks
+  void setMaxBytes(size_t maxBytes)
+  {
+    maxBytes_ = maxBytes;
+    evict();
+  }
+
+  void clear()
+  {
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+  }
+
+  size_t hits() const { return hits_; }
+  size_t misses() const { return misses_; }
+  size_t evictions() const { return evictions_; }
+  size_t bytes() const { return bytes_; }
+  size_t maxBytes() const { return maxBytes_; }
+  size_t size() const { return entries_.size(); }
+
+  void printStats(std::ostream &out) const
+  {
+    size_t lookups = hits_ + misses_;
+    out << "Spectrum cache: " << hits_ << " hits, " << misses_ << " misses ("
+        << (lookups ? 100.0 * hits_ / lookups : 0.0) << "% hit rate), " << evictions_ << " evictions, "
+        << size() << " spectra in " << bytes_ / (1024.0 * 1024.0) << " MB" << std::endl;
+  }
+
+private:
+  typedef std::list< std::pair<spectrumKey, cv::Mat> > entryList;
+
+  static size_t sizeOf(const cv::Mat &m) { return m.total() * m.elemSize(); }
+
+  // Least recently used entries out until the total fits the limit (the newest one always stays)
+  void evict()
+  {
+    while(bytes_ > maxBytes_ && entries_.size() > 1)
+    {
+      bytes_ -= sizeOf(entries_.back().second);
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+      evictions_++;
+    }
+  }
+
+  size_t maxBytes_;
+  size_t bytes_;
+  size_t hits_;
+  size_t misses_;
+  size_t evictions_;
+  entryList entries_;               // Most recently used first
+  std::map<spectrumKey, entryList::iterator> index_;
+};
+
+#endif
@@ -13,75 +13,66 @@
 
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <chrono>
 
+#include "boxGaussian.h"
+#include "convolve.h"
+#include "filterBank.h"
+#include "frequencyFilter.h"
+#include "imageMetrics.h"
+#include "overlapSave.h"
+#include "recursiveGaussian.h"
+#include "spectrumCache.h"
+
 //#define DISPLAY 1       // Show images if un-commented
 #define NUM_POINTS  20 // Num of points for the final graphic
 #define NUM_TIME_IT 4  // Num of measurements before compute the mean time
+#define NUM_METHODS 6  // Num of timed strategies (columns of "data.dat")
 
 using namespace std;
 using namespace cv;
 
 //Global Variables
 string filename = "data.dat";
-string titles = "ksize\ttarr0\ttarr1\ttarr2";                       // Titles on the "data.dat" file (gnuplot)l
-vector< vector<double> > finalTimes(NUM_POINTS, vector<double>(3)); // Vector for timing results:
+string modelFile = "costModel.txt";                                 // Per-machine cost model for convolve()
+string titles = "ksize\ttarr0\ttarr1\ttarr2\ttarr3\ttarr4\ttarr5"; // Titles on the "data.dat" file (gnuplot)l
+vector< vector<double> > finalTimes(NUM_POINTS, vector<double>(NUM_METHODS)); // Vector for timing results:
 //Col0: Space Domain, 2D Kernel
 //Col1: Space Domain, Sep Kernel
 //Col2: Frequency Domain, 2D Kernel
-
-// Comparison Metric PSNR
-double getPSNR(const Mat& I1, const Mat& I2)
-{
-    Mat s1;
-    absdiff(I1, I2, s1);       // |I1 - I2|
-    s1.convertTo(s1, CV_32F);  // cannot make a square on 8 bits
-    s1 = s1.mul(s1);           // |I1 - I2|^2
-
-    Scalar s = sum(s1);        // sum elements per channel
-
-    double sse = s.val[0] + s.val[1] + s.val[2]; // sum channels
-
-    if( sse <= 1e-10) // for small values return zero
-        return 0;
-    else
-    {
-        double mse  = sse / (double)(I1.channels() * I1.total());
-        double psnr = 10.0 * log10((255 * 255) / mse);
-        return psnr;
-    }
-}
-
-// Quadrants Re-ordering
+//Col3: Frequency Domain, 2D Kernel, Overlap-Save Tiles
+//Col4: Space Domain, Recursive (IIR) Gaussian
+//Col5: Space Domain, Box Filter Cascade (approximate)
+spectrumCache kernelSpectra;                                        // Kernel spectra, computed once per kernel
+frequencyFilter spectrumEngine;                                     // Spectrum product buffer, reused
+
+// Quadrants Re-ordering, in place: row y of the top half trades halves with row y + cy of the bottom half,
+// so every pair of rows is swapped once while in cache and no temporary matrix is needed
 Mat shift(Mat magI) 
 {
-    Mat result;
     magI = magI(Rect(0, 0, magI.cols & -2, magI.rows & -2)); // Crop for odd number of rows or columns
  
     int cx = magI.cols/2;
     int cy = magI.rows/2;
+    size_t half = cx * magI.elemSize();                      // Bytes of half a row
  
-    Mat q0(magI, Rect(0, 0, cx, cy));   // Top-Left - Create a ROI per quadrant
-    Mat q1(magI, Rect(cx, 0, cx, cy));  // Top-Right
-    Mat q2(magI, Rect(0, cy, cx, cy));  // Bottom-Left
-    Mat q3(magI, Rect(cx, cy, cx, cy)); // Bottom-Right
- 
-    Mat tmp;                            // swap quadrants (Top-Left with Bottom-Right)
-    q0.copyTo(tmp);
-    q3.copyTo(q0);
-    tmp.copyTo(q3);
-    q1.copyTo(tmp);                     // swap quadrant (Top-Right with Bottom-Left)
-    q2.copyTo(q1);
-    tmp.copyTo(q2);
+    for(int y = 0; y < cy; y++)
+    {
+        uchar *top = magI.ptr(y);
+        uchar *bottom = magI.ptr(y + cy);
+        std::swap_ranges(top, top + half, bottom + half);     // Top-Left with Bottom-Right
+        std::swap_ranges(top + half, top + 2 * half, bottom); // Top-Right with Bottom-Left
+    }
  
     return magI;
 }
 
 
-// Fourier Transform
+// Fourier Transform of a real image: packed half spectrum (CCS), the other half is its complex conjugate
 Mat computeDFT(Mat image) 
 {
     Mat padded;
@@ -90,31 +81,25 @@ Mat computeDFT(Mat image)
     // create output image of optimal size
     copyMakeBorder(image, padded, 0, m - image.rows, 0, n - image.cols, BORDER_CONSTANT, Scalar::all(0));
     // copy the source image, on the border add zero values
+    Mat spectrum = Mat_<float>(padded);
+    dft(spectrum, spectrum);    // real to complex: one float plane, same size as the image
+    return spectrum;
+}
+
+// Full complex spectrum (two planes), only for displaying the magnitude
+Mat computeComplexDFT(Mat image)
+{
+    Mat padded;
+    int m = getOptimalDFTSize(image.rows);
+    int n = getOptimalDFTSize(image.cols);
+    copyMakeBorder(image, padded, 0, m - image.rows, 0, n - image.cols, BORDER_CONSTANT, Scalar::all(0));
     Mat planes[] = { Mat_< float> (padded), Mat::zeros(padded.size(), CV_32F) };
-    // create a complex matrix
     Mat complex;
     merge(planes, 2, complex);
     dft(complex, complex, DFT_COMPLEX_OUTPUT);  // fourier transform
     return complex;
 }
 
-// Inverse Fourier Transform
-Mat computeIDFT(Mat complex)
-{
-    Mat result;
-    idft(complex, result);
-    // equivalent to:
-    // dft(complex, result, DFT_INVERSE + DFT_SCALE);
-    Mat planes[] = {
-        Mat::zeros(complex.size(), CV_32F),
-        Mat::zeros(complex.size(), CV_32F)
-    };
-    split(result, planes); // planes[0] = Re(DFT(I)), planes[1] = Im(DFT(I))
-    magnitude(planes[0], planes[1], result); // sqrt(Re(DFT(I))^2 + Im(DFT(I))^2)
-    normalize(result, result, 0, 1, NORM_MINMAX);
-    return result;
-}
-
 // Plot Magnitude - Frquency Domain
 void displayMag(Mat complex) 
 {
@@ -152,10 +137,10 @@ void createData()
   {
     ksize = std::to_string((10 * i) + 9);
     tmp_wr = ksize + "\t";
-    for(int j = 0; j < NUM_TIME_IT; j++)
+    for(int j = 0; j < NUM_METHODS; j++)
     {
       tmp_time = std::to_string(finalTimes[i][j]);
-      (j == (NUM_TIME_IT - 1)) ? tmp_wr += tmp_time : tmp_wr += (tmp_time + "\t");
+      (j == (NUM_METHODS - 1)) ? tmp_wr += tmp_time : tmp_wr += (tmp_time + "\t");
     }
     system((times_wr + tmp_wr + + "\" >> " + filename).c_str());
     tmp_wr = "";
@@ -163,39 +148,39 @@ void createData()
 }
 
 
-// Padding for a Kernel by considering optimal dimensions
-Mat padded2DKernel(Mat Kernel, int maxHeight, int maxWidth)
+// Kernel in a maxHeight x maxWidth plane with its center at the origin and the rest wrapped around the
+// edges (ifftshift): the circular convolution leaves the filtered image in place, with no shift afterwards
+Mat wrappedKernel(Mat Kernel, int maxHeight, int maxWidth)
 {
-  Mat result(cv::Size(maxWidth, maxHeight), CV_32F);
-  result = 0;
-  int krows = Kernel.rows;
-  int kcols = Kernel.cols;
-  bool inRangeH = false;
-  bool inRangeW = false;
-  int origInImagex = ((maxHeight / 2) - (krows / 2));
-  int origInImagey = ((maxWidth / 2) - (kcols / 2));
-  int k = 0, l = 0;
-  for(int i = 0; i < maxHeight; i++)
-  { 
-    for(int j = 0; j < maxWidth; j++)
-    {
-      inRangeH = (i >= origInImagey) && (i < (origInImagey + krows));
-      inRangeW = (j >= origInImagex) && (j < (origInImagex + kcols));
-      if(inRangeH && inRangeW)
-      {
-        result.at<float>(Point(i, j)) = Kernel.at<float>(Point(k, l));
-        l++;
-        if(l == kcols)
-        {
-          l = 0;
-          k++;
-        }
-      }
-    }
-  }
+  Mat result = Mat::zeros(maxHeight, maxWidth, CV_32F);
+  int ay = Kernel.rows / 2;                 // Center (anchor) of the kernel
+  int ax = Kernel.cols / 2;
+  int below = Kernel.rows - ay;             // Rows from the center down, columns from the center right
+  int right = Kernel.cols - ax;
+
+  // Four blocks: from the center on to the start of the plane, before the center to its end
+  Kernel(Rect(ax, ay, right, below)).copyTo(result(Rect(0, 0, right, below)));
+  if(ax > 0)
+    Kernel(Rect(0, ay, ax, below)).copyTo(result(Rect(maxWidth - ax, 0, ax, below)));
+  if(ay > 0)
+    Kernel(Rect(ax, 0, right, ay)).copyTo(result(Rect(0, maxHeight - ay, right, ay)));
+  if(ax > 0 && ay > 0)
+    Kernel(Rect(0, 0, ax, ay)).copyTo(result(Rect(maxWidth - ax, maxHeight - ay, ax, ay)));
   return result;
 }
 
+// Spectrum of the filterSize x filterSize Gaussian wrapped in a plane of the padded size: only the first
+// lookup places and transforms it, the next ones are cache hits
+Mat gaussianSpectrum(int filterSize, float sigma, Size plane)
+{
+  spectrumKey kernelKey = { "gaussian", filterSize, sigma, plane.height, plane.width };
+  return kernelSpectra.get(kernelKey, [&]()
+  {
+    Mat gaussian_filter = cv::getGaussianKernel(filterSize, sigma, CV_32F);
+    return computeDFT(wrappedKernel(gaussian_filter * gaussian_filter.t(), plane.height, plane.width));
+  });
+}
+
 
 /*
 * Main Function
@@ -226,9 +211,11 @@ int main(int argc, char** argv)
   #endif
 
   Mat complexI = computeDFT(src);                                           // Input image in frequency domain
+  // Room for the whole-image spectrum of every kernel of the sweep, plus the default budget for the tiles
+  kernelSpectra.setMaxBytes(NUM_POINTS * complexI.total() * complexI.elemSize() + SPECTRUM_CACHE_BYTES);
 
   #ifdef DISPLAY
-  displayMag(complexI);                                                   // Plotting the Magnitude
+  displayMag(computeComplexDFT(src));                                     // Plotting the Magnitude
   #endif
 
   int filterSize = 0;
@@ -297,14 +284,9 @@ int main(int argc, char** argv)
     Mat padded;                            //expand input image to optimal size
     Mat filter2D_Fresult;
     Mat display_2DFresult;
-    Mat padded_kernel;
 
-    padded_kernel = padded2DKernel(unifiedKernel, complexI.rows, complexI.cols);
-    /*namedWindow( "Display result 2Dk", WINDOW_AUTOSIZE ); 
-    cv::resize(padded_kernel, padded_kernel, cv::Size(), 0.25, 0.25);
-    imshow( "Display result 2Dk", padded_kernel );
-    waitKey(0);*/
-    Mat complexKernel = computeDFT(padded_kernel);                            // Gaussian Kernel in Frequency
+    // Gaussian Kernel in Frequency (wrapped at the origin)
+    Mat complexKernel = gaussianSpectrum(filterSize, sigma, complexI.size());
 
     // Unified Kernel
     std::chrono::duration<double> diffC;
@@ -312,8 +294,8 @@ int main(int argc, char** argv)
     for(int j = 0; j < NUM_TIME_IT; j++)
     {
       auto startC = std::chrono::high_resolution_clock::now();
-      mulSpectrums(complexI, complexKernel, filter2D_Fresult, 0);      
-      filter2D_Fresult = computeIDFT(filter2D_Fresult);
+      complexKernel = gaussianSpectrum(filterSize, sigma, complexI.size());  // Every frame: a cache hit
+      spectrumEngine.apply(complexI, complexKernel, src.size(), filter2D_Fresult);  // Product, IDFT, 8 bits
 
       auto endC = std::chrono::high_resolution_clock::now();
       diffC = endC - startC;
@@ -321,7 +303,8 @@ int main(int argc, char** argv)
     }
     finalTimes[i][2] = avgC;
 
-    filter2D_Fresult = shift(filter2D_Fresult);
+    cout << "ksize " << filterSize << ": frequency domain PSNR vs filter2D = "
+         << getPSNR(filter2D_result, filter2D_Fresult) << " dB" << endl;
 
     #ifdef DISPLAY
     namedWindow( "Display result 2D - Frequency Domain", WINDOW_AUTOSIZE ); 
@@ -330,7 +313,160 @@ int main(int argc, char** argv)
     waitKey(0);
     #endif
 
+    // Overlap-Save: tiles of the image against the spectrum of the kernel at the tile size
+    Mat overlapSave_result;
+    Mat display_overlapSave;
+    std::chrono::duration<double> diffD;
+    double avgD = 0;
+    for(int j = 0; j < NUM_TIME_IT; j++)
+    {
+      auto startD = std::chrono::high_resolution_clock::now();
+      overlapSaveFilter(src, overlapSave_result, unifiedKernel, kernelSpectra, "gaussian", sigma);
+      auto endD = std::chrono::high_resolution_clock::now();
+      diffD = endD - startD;
+      avgD += (1.0 / NUM_TIME_IT) * diffD.count();
+    }
+    finalTimes[i][3] = avgD;
+    cout << "ksize " << filterSize << ": overlap-save tile " << overlapTileSize(filterSize)
+         << ", PSNR vs filter2D = " << getPSNR(filter2D_result, overlapSave_result) << " dB" << endl;
+
+    #ifdef DISPLAY
+    namedWindow( "Display result 2D - Frequency Domain: Overlap-Save", WINDOW_AUTOSIZE ); 
+    cv::resize(overlapSave_result, display_overlapSave, cv::Size(), 0.25, 0.25);
+    imshow( "Display result 2D - Frequency Domain: Overlap-Save", display_overlapSave );
+    waitKey(0);
+    #endif
+
+    /**************************
+    * RECURSIVE (IIR) GAUSSIAN
+    ***************************/
+    // Young - van Vliet: the same work per pixel whatever the sigma (no kernel size involved)
+    Mat recursive_result;
+    Mat display_recursive;
+    std::chrono::duration<double> diffF;
+    double avgF = 0;
+    for(int j = 0; j < NUM_TIME_IT; j++)
+    {
+      auto startF = std::chrono::high_resolution_clock::now();
+      recursiveGaussian(src, recursive_result, sigma);
+      auto endF = std::chrono::high_resolution_clock::now();
+      diffF = endF - startF;
+      avgF += (1.0 / NUM_TIME_IT) * diffF.count();
+    }
+    finalTimes[i][4] = avgF;
+    cout << "ksize " << filterSize << ": recursive Gaussian PSNR vs filter2D = "
+         << getPSNR(filter2D_result, recursive_result) << " dB, SSIM = "
+         << getMSSIM(filter2D_result, recursive_result) << endl;
+
+    #ifdef DISPLAY
+    namedWindow( "Display result 2D - Space Domain: Recursive Gaussian", WINDOW_AUTOSIZE ); 
+    cv::resize(recursive_result, display_recursive, cv::Size(), 0.25, 0.25);
+    imshow( "Display result 2D - Space Domain: Recursive Gaussian", display_recursive );
+    waitKey(0);
+    #endif
+
+    /********************
+    * BOX FILTER CASCADE
+    *********************/
+    // Approximate: BOX_PASSES running-sum boxes with the variance of the Gaussian, O(1) per pixel
+    Mat box_result;
+    Mat display_box;
+    std::chrono::duration<double> diffG;
+    double avgG = 0;
+    for(int j = 0; j < NUM_TIME_IT; j++)
+    {
+      auto startG = std::chrono::high_resolution_clock::now();
+      boxGaussian(src, box_result, sigma, BOX_PASSES);
+      auto endG = std::chrono::high_resolution_clock::now();
+      diffG = endG - startG;
+      avgG += (1.0 / NUM_TIME_IT) * diffG.count();
+    }
+    finalTimes[i][5] = avgG;
+
+    // Accuracy against the exact kernel for every cascade length
+    cout << "ksize " << filterSize << ": box cascade PSNR vs filter2D =";
+    for(int passes = 3; passes <= BOX_MAX_PASSES; passes++)
+    {
+      Mat box_accuracy;
+      boxGaussian(src, box_accuracy, sigma, passes);
+      cout << " " << getPSNR(filter2D_result, box_accuracy) << " dB / SSIM "
+           << getMSSIM(filter2D_result, box_accuracy) << " (" << passes << " boxes, sigma "
+           << boxSigma(boxWidths(sigma, passes)) << " for " << sigma << ")";
+    }
+    cout << endl;
+
+    #ifdef DISPLAY
+    namedWindow( "Display result 2D - Space Domain: Box Cascade", WINDOW_AUTOSIZE ); 
+    cv::resize(box_result, display_box, cv::Size(), 0.25, 0.25);
+    imshow( "Display result 2D - Space Domain: Box Cascade", display_box );
+    waitKey(0);
+    #endif
+
+  }
+
+  /****************************
+  * AUTOMATIC STRATEGY CHOICE
+  *****************************/
+  // Cost model of this machine: the times per pixel just measured, averaged with those of the previous runs
+  convolveModel costModel;
+  if(costModel.load(modelFile))
+    cout << "Cost model of the previous runs loaded from " << modelFile << ", averaging this run in" << endl;
+  for(int i = 0; i < NUM_POINTS; i++)
+  {
+    filterSize = (10 * i) + 9;
+    costModel.addSample(RouteDirect2D, filterSize, finalTimes[i][0] / src.total());
+    costModel.addSample(RouteSeparable, filterSize, finalTimes[i][1] / src.total());
+    costModel.addSample(RouteOverlapSave, filterSize, finalTimes[i][3] / src.total());
+  }
+  costModel.save(modelFile);
+
+  Mat convolve_result;
+  for(int i = 0; i < NUM_POINTS; i++)
+  {
+    filterSize = (10 * i) + 9;
+    sigma = ((filterSize + 2) / 6);
+    Mat gaussian_filter = cv::getGaussianKernel(filterSize, sigma, CV_32F);
+    Mat unifiedKernel = gaussian_filter * gaussian_filter.t();
+
+    auto startE = std::chrono::high_resolution_clock::now();
+    convolveRoute route = convolve(src, convolve_result, unifiedKernel, costModel, kernelSpectra);
+    auto endE = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diffE = endE - startE;
+    cout << "ksize " << filterSize << ": convolve() -> " << routeName(route) << ", " << diffE.count() << " s"
+         << endl;
+  }
+
+  /*************
+  * FILTER BANK
+  **************/
+  // All the Gaussians at once: one forward transform, then the products and inverses on every core
+  vector<Mat> bankSpectra;
+  for(int i = 0; i < NUM_POINTS; i++)
+  {
+    filterSize = (10 * i) + 9;
+    sigma = ((filterSize + 2) / 6);
+    bankSpectra.push_back(gaussianSpectrum(filterSize, sigma, complexI.size()));
+  }
+  filterBank gaussianBank;
+  gaussianBank.apply(complexI, bankSpectra, src.size());                    // Allocates the reused buffers
+
+  double sequentialTime = 0;
+  for(int i = 0; i < NUM_POINTS; i++)
+    sequentialTime += finalTimes[i][2];
+  std::chrono::duration<double> diffH;
+  double avgH = 0;
+  for(int j = 0; j < NUM_TIME_IT; j++)
+  {
+    auto startH = std::chrono::high_resolution_clock::now();
+    Mat bankInput = computeDFT(src);
+    gaussianBank.apply(bankInput, bankSpectra, src.size());
+    auto endH = std::chrono::high_resolution_clock::now();
+    diffH = endH - startH;
+    avgH += (1.0 / NUM_TIME_IT) * diffH.count();
   }
+  cout << "Filter bank: " << NUM_POINTS << " Gaussians in " << avgH << " s, forward transform included ("
+       << sequentialTime << " s one at a time)" << endl;
+  kernelSpectra.printStats(cout);                                            // After the last lookup
 
   //Plotting Timing Results: GNU-Plot
   cout << "Generating the Timing Plot..." << endl;
@@ -0,0 +1,382 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Batch: min and max filters over a whole directory (or file list) as a three-stage pipeline
+*
+*   load (decode straight to gray) -> filter (streaming min and max) -> save (encode both results)
+*
+* Each stage has its own pool of threads and the stages are connected by bounded queues (see
+* ../Common/boundedQueue.h), so decoding, filtering and encoding of different images overlap while the
+* images in flight stay bounded. At the end it reports the sustained images/s and how busy each stage was.
+**************************************************************************************************************/
+
+// LTI-Lib Headers
+#include "ltiIOImage.h"
+#include "ltiImage.h"
+#include "ltiChannel8.h"
+
+// Standard Headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "boundedQueue.h"
+#include "grayIngest.h"
+#include "morphContext.h"
+#include "rgbaGray.h"
+
+using namespace std;
+
+#define DEFAULT_SE_SIZE 5           // Default structuring element
+#define DEFAULT_QUEUE_DEPTH 8       // Images waiting between two stages
+
+// One image on its way through the pipeline
+struct batchJob
+{
+  string path;
+  string name;                      // Output name, <name>_min and <name>_max
+  shared_ptr<grayInput> input;
+  grayBuffer minBuf;
+  grayBuffer maxBuf;
+};
+typedef shared_ptr<batchJob> batchJobPtr;
+
+// Work done by the threads of one stage; busy excludes the time blocked on the queues
+struct stageStats
+{
+  string name;
+  int threads;
+  double busy;
+  long images;
+  mutex lock;
+
+  void add(double seconds)
+  {
+    lock_guard<mutex> guard(lock);
+    busy += seconds;
+    images++;
+  }
+};
+
+/*
+ * Help
+ */
+void usage()
+{
+  cout << "Usage: Batch <directory | list.txt | images...> -o <output dir> [-s se] [-j load filter save]"
+       << " [-q depth] [-e png|pgm]" << endl;
+  cout << "  directory  every image in it (png, jpg, bmp, pgm); list.txt one path per line." << endl;
+  cout << "  -o directory for <name>_min and <name>_max." << endl;
+  cout << "  -s structuring element size, default " << DEFAULT_SE_SIZE << "." << endl;
+  cout << "  -j threads of the load, filter and save stages, default 1, cores - 2 and 1." << endl;
+  cout << "  -q images waiting between two stages, default " << DEFAULT_QUEUE_DEPTH << "." << endl;
+  cout << "  -e output format: png (default, encoded by the LTI-Lib) or pgm (written through mmap)." << endl;
+  cout << "  -h show this help." << endl;
+}
+
+
+bool saveGray(const grayBuffer &buf, const string &path, const string &format, string &error)
+{
+  if(format == "pgm")
+  {
+    mappedImage out;
+    if(!out.create(path, buf.rows, buf.cols))
+    {
+      error = out.error();
+      return false;
+    }
+    for(int y = 0; y < buf.rows; y++)
+      std::copy(buf[y], buf[y] + buf.cols, out.row(y));
+    return true;
+  }
+  lti::ioImage saver;
+  lti::channel8 img;
+  imageFromBuffer(buf, img);
+  if(!saver.save(path, img))
+  {
+    error = "Could not write " + path + ": " + saver.getStatusString();
+    return false;
+  }
+  return true;
+}
+
+
+bool isDirectory(const string &path)
+{
+  struct stat info;
+  return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+bool hasExtension(const string &path, const char *const *extensions)
+{
+  size_t dot = path.find_last_of('.');
+  if(dot == string::npos)
+    return false;
+  string extension = path.substr(dot + 1);
+  std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+  for(int e = 0; extensions[e] != NULL; e++)
+    if(extension == extensions[e])
+      return true;
+  return false;
+}
+
+// The images of a directory (sorted), the lines of a list file, or the paths themselves; false if a
+// directory cannot be read
+bool collectInputs(const vector<string> &args, vector<string> &paths)
+{
+  static const char *const imageTypes[] = { "png", "jpg", "jpeg", "bmp", "pgm", "ppm", NULL };
+  static const char *const listTypes[] = { "txt", "lst", NULL };
+  paths.clear();
+  for(size_t a = 0; a < args.size(); a++)
+  {
+    if(isDirectory(args[a]))
+    {
+      vector<string> entries;
+      DIR *dir = opendir(args[a].c_str());
+      if(dir == NULL)
+      {
+        cerr << "Could not read the directory " << args[a] << endl;
+        return false;
+      }
+      for(struct dirent *entry = readdir(dir); entry != NULL; entry = readdir(dir))
+        if(entry->d_name[0] != '.' && hasExtension(entry->d_name, imageTypes))
+          entries.push_back(args[a] + "/" + entry->d_name);
+      closedir(dir);
+      std::sort(entries.begin(), entries.end());
+      paths.insert(paths.end(), entries.begin(), entries.end());
+    }
+    else if(hasExtension(args[a], listTypes))
+    {
+      ifstream list(args[a].c_str());
+      string line;
+      while(getline(list, line))
+        if(!line.empty())
+          paths.push_back(line);
+    }
+    else
+      paths.push_back(args[a]);
+  }
+  return true;
+}
+
+/*
+ * Output name of every input: its file name without the extension, or with the extension ('.' as '_')
+ * when two inputs share it (a.png and a.jpg). False, with the clashing paths in error, if two inputs still
+ * get the same name (the same file name in two directories).
+ */
+bool outputNames(const vector<string> &paths, vector<string> &names, string &error)
+{
+  vector<string> files(paths.size());
+  map<string, int> stems;
+  names.resize(paths.size());
+  for(size_t p = 0; p < paths.size(); p++)
+  {
+    files[p] = paths[p].substr(paths[p].find_last_of('/') + 1);
+    names[p] = files[p].substr(0, files[p].find_last_of('.'));
+    stems[names[p]]++;
+  }
+
+  map<string, size_t> owner;
+  for(size_t p = 0; p < paths.size(); p++)
+  {
+    if(stems[names[p]] > 1)
+    {
+      names[p] = files[p];
+      std::replace(names[p].begin(), names[p].end(), '.', '_');
+    }
+    if(owner.count(names[p]))
+    {
+      error = paths[owner[names[p]]] + " and " + paths[p] + " would both be saved as " + names[p] +
+              "_min/_max";
+      return false;
+    }
+    owner[names[p]] = p;
+  }
+  return true;
+}
+
+// <output dir>/<name><suffix>.<format>
+string outputPath(const string &outDir, const string &name, const string &suffix, const string &format)
+{
+  return outDir + "/" + name + suffix + "." + format;
+}
+
+double secondsSince(const std::chrono::high_resolution_clock::time_point &start)
+{
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+
+int main(int argc, char **argv)
+{
+  vector<string> args;
+  string outDir, format = "png";
+  int se = DEFAULT_SE_SIZE;
+  int queueDepth = DEFAULT_QUEUE_DEPTH;
+  int loadThreads = 1, saveThreads = 1;
+  int filterThreads = max(1, (int)thread::hardware_concurrency() - 2);
+
+  for(int i = 1; i < argc; i++)
+  {
+    string arg = argv[i];
+    if(arg == "-h")
+    {
+      usage();
+      return EXIT_SUCCESS;
+    }
+    else if(arg == "-j" && i + 3 < argc)
+    {
+      loadThreads = atoi(argv[++i]);
+      filterThreads = atoi(argv[++i]);
+      saveThreads = atoi(argv[++i]);
+    }
+    else if((arg == "-o" || arg == "-s" || arg == "-q" || arg == "-e") && i + 1 < argc)
+    {
+      string value = argv[++i];
+      if(arg == "-o")
+        outDir = value;
+      else if(arg == "-s")
+        se = atoi(value.c_str());
+      else if(arg == "-q")
+        queueDepth = atoi(value.c_str());
+      else
+        format = value;
+    }
+    else
+      args.push_back(arg);
+  }
+
+  vector<string> paths, names;
+  string namesError;
+  if(!collectInputs(args, paths))
+    return EXIT_FAILURE;
+  if(!outputNames(paths, names, namesError))
+  {
+    cerr << namesError << endl;
+    return EXIT_FAILURE;
+  }
+  if(paths.empty() || outDir.empty() || !isDirectory(outDir) || se < 1 || queueDepth < 1 ||
+     loadThreads < 1 || filterThreads < 1 || saveThreads < 1 || (format != "png" && format != "pgm"))
+  {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  cout << paths.size() << " images, se=" << se << ", threads " << loadThreads << "/" << filterThreads << "/"
+       << saveThreads << " (load/filter/save), queues of " << queueDepth << endl;
+
+  boundedQueue<batchJobPtr> loaded(queueDepth), filtered(queueDepth);
+  stageStats stats[3];
+  stats[0].name = "load";
+  stats[1].name = "filter";
+  stats[2].name = "save";
+  stats[0].threads = loadThreads;
+  stats[1].threads = filterThreads;
+  stats[2].threads = saveThreads;
+  for(int s = 0; s < 3; s++)
+  {
+    stats[s].busy = 0;
+    stats[s].images = 0;
+  }
+  atomic<size_t> nextPath(0);
+  atomic<long> failed(0), saved(0);
+  mutex logLock;
+
+  auto fail = [&](const string &message)
+  {
+    lock_guard<mutex> guard(logLock);
+    cerr << message << endl;
+    failed++;
+  };
+
+  auto loadStage = [&]()
+  {
+    for(size_t p = nextPath++; p < paths.size(); p = nextPath++)
+    {
+      auto start = std::chrono::high_resolution_clock::now();
+      batchJobPtr job(new batchJob());
+      job->path = paths[p];
+      job->name = names[p];
+      job->input.reset(new grayInput());
+      bool ok = job->input->open(job->path, ltiDecodeGray);
+      stats[0].add(secondsSince(start));
+      if(ok)
+        loaded.push(job);
+      else
+        fail(job->input->error());
+    }
+  };
+
+  auto filterStage = [&]()
+  {
+    morphContext context;                   // Scratch of this thread, reused for every image
+    batchJobPtr job;
+    while(loaded.pop(job))
+    {
+      auto start = std::chrono::high_resolution_clock::now();
+      context.apply(job->input->view(), job->minBuf, se, MorphMin);
+      context.apply(job->input->view(), job->maxBuf, se, MorphMax);
+      job->input.reset();                   // Unmaps or frees the input before the job waits to be saved
+      stats[1].add(secondsSince(start));
+      filtered.push(job);
+    }
+  };
+
+  auto saveStage = [&]()
+  {
+    batchJobPtr job;
+    while(filtered.pop(job))
+    {
+      auto start = std::chrono::high_resolution_clock::now();
+      string error;
+      if(!saveGray(job->minBuf, outputPath(outDir, job->name, "_min", format), format, error) ||
+         !saveGray(job->maxBuf, outputPath(outDir, job->name, "_max", format), format, error))
+        fail(error);
+      else
+        saved++;
+      stats[2].add(secondsSince(start));
+    }
+  };
+
+  // Every stage closes the queue it feeds once all its threads are done
+  auto start = std::chrono::high_resolution_clock::now();
+  vector<thread> loaders, filters, savers;
+  for(int t = 0; t < loadThreads; t++)
+    loaders.push_back(thread(loadStage));
+  for(int t = 0; t < filterThreads; t++)
+    filters.push_back(thread(filterStage));
+  for(int t = 0; t < saveThreads; t++)
+    savers.push_back(thread(saveStage));
+  for(size_t t = 0; t < loaders.size(); t++)
+    loaders[t].join();
+  loaded.close();
+  for(size_t t = 0; t < filters.size(); t++)
+    filters[t].join();
+  filtered.close();
+  for(size_t t = 0; t < savers.size(); t++)
+    savers[t].join();
+  double wall = secondsSince(start);
+
+  cout << saved << " images (" << failed << " failed) in " << wall << " s, " << saved / wall << " images/s"
+       << endl;
+  for(int s = 0; s < 3; s++)
+    cout << "  " << stats[s].name << ": " << stats[s].threads << " threads, busy " << stats[s].busy << " s, "
+         << "utilisation " << 100.0 * stats[s].busy / (stats[s].threads * wall) << "%" << endl;
+  return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,142 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Aligned Image: 8-bit image whose rows start on 64-byte boundaries, with a halo around it and a stride
+* padded to whole vectors, so SIMD kernels can use aligned full-width loads with no tail or border cases
+*
+* Layout of every row (stride bytes):
+*   [ left halo, rounded up to 64 ][ cols pixels ][ padding: cols rounded up to 16, plus halo, up to 64 ]
+* plus halo rows above and below the image. Pixel (y, x) is valid for -halo <= y < rows + halo and
+* -halo <= x < cols + halo, and a 16-byte vector loaded at any x < cols may read up to halo pixels past
+* its end.
+**************************************************************************************************************/
+
+#ifndef _ALIGNED_IMAGE_H_
+#define _ALIGNED_IMAGE_H_
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define IMAGE_ALIGNMENT 64          // Cache line, and a multiple of every vector width
+#define VECTOR_WIDTH 16             // NEON q registers
+
+// Non-owning window into an alignedImage (rows keep the parent's stride; x0 % 64 == 0 keeps them aligned)
+struct imageView
+{
+  uint8_t *data;                    // Pixel (0, 0) of the view
+  int rows;
+  int cols;
+  ptrdiff_t stride;
+
+  uint8_t *row(int y) const { return data + y * stride; }
+  uint8_t *operator[](int y) const { return row(y); }
+};
+
+class alignedImage
+{
+public:
+  alignedImage()
+    : buffer_(NULL), capacity_(0), rows_(0), cols_(0), halo_(0), left_(0), stride_(0), height_(0) {}
+  alignedImage(int rows, int cols, int halo) : buffer_(NULL), capacity_(0) { allocate(rows, cols, halo); }
+  ~alignedImage() { std::free(buffer_); }
+
+  // (Re)allocates only when the geometry grows past what the buffer already holds
+  void allocate(int rows, int cols, int halo)
+  {
+    int left = roundUp(halo, IMAGE_ALIGNMENT);
+    ptrdiff_t stride = left + roundUp(roundUp(cols, VECTOR_WIDTH) + halo, IMAGE_ALIGNMENT);
+    int height = rows + 2 * halo;
+    if((size_t)(stride * height) > capacity_)
+    {
+      std::free(buffer_);
+      void *memory = NULL;
+      if(posix_memalign(&memory, IMAGE_ALIGNMENT, stride * height) != 0)
+        throw std::bad_alloc();
+      buffer_ = (uint8_t *)memory;
+      capacity_ = stride * height;
+    }
+    rows_ = rows;
+    cols_ = cols;
+    halo_ = halo;
+    left_ = left;
+    stride_ = stride;
+    height_ = height;
+  }
+
+  int rows() const { return rows_; }
+  int columns() const { return cols_; }
+  int halo() const { return halo_; }
+  ptrdiff_t stride() const { return stride_; }
+
+  uint8_t *row(int y) { return buffer_ + (y + halo_) * stride_ + left_; }
+  const uint8_t *row(int y) const { return buffer_ + (y + halo_) * stride_ + left_; }
+  uint8_t *operator[](int y) { return row(y); }
+  const uint8_t *operator[](int y) const { return row(y); }
+
+  imageView view() { return view(0, 0, rows_, cols_); }
+  imageView view(int y0, int x0, int rows, int cols)
+  {
+    imageView v = { row(y0) + x0, rows, cols, stride_ };
+    return v;
+  }
+
+  // Sets everything outside the image (halo rows, halo columns and stride padding) to value
+  void fillHalo(uint8_t value)
+  {
+    for(int y = -halo_; y < height_ - halo_; y++)
+    {
+      uint8_t *line = row(y);
+      if(y < 0 || y >= rows_)
+        std::fill(line - left_, line - left_ + stride_, value);
+      else
+      {
+        std::fill(line - left_, line, value);
+        std::fill(line + cols_, line - left_ + stride_, value);
+      }
+    }
+  }
+
+  // Copy from/to any image type with rows(), columns() and contiguous img[y][x] rows (lti::channel8)
+  template<class Img>
+  void copyFrom(const Img &img, int halo)
+  {
+    allocate(img.rows(), img.columns(), halo);
+    for(int y = 0; y < rows_; y++)
+      std::copy(&img[y][0], &img[y][0] + cols_, row(y));
+  }
+
+  template<class Img>
+  void copyTo(Img &img) const
+  {
+    for(int y = 0; y < rows_; y++)
+      std::copy(row(y), row(y) + cols_, &img[y][0]);
+  }
+
+private:
+  alignedImage(const alignedImage &);
+  alignedImage &operator=(const alignedImage &);
+
+  static int roundUp(int bytes, int multiple)
+  {
+    return ((bytes + multiple - 1) / multiple) * multiple;
+  }
+
+  uint8_t *buffer_;
+  size_t capacity_;                 // Allocated bytes
+  int rows_;
+  int cols_;
+  int halo_;
+  int left_;                        // Left halo in bytes, a multiple of IMAGE_ALIGNMENT
+  ptrdiff_t stride_;
+  int height_;                      // Allocated rows, halo included
+};
+
+#endif
@@ -0,0 +1,222 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Allocation Accounting: heap allocations, allocated bytes, peak heap and peak RSS per kernel invocation
+*
+* Opt-in: build with "make ALLOCSTATS=yes" (defines ALLOC_STATS). The hooks interpose the glibc allocator
+* (malloc, calloc, realloc, memalign family and free), so operator new, the LTI-Lib and OpenCV allocations
+* are all counted. Without ALLOC_STATS everything below compiles to empty scopes.
+*
+* This header defines the allocator, so it must be included by a single translation unit (each version is
+* one .cpp file).
+**************************************************************************************************************/
+
+#ifndef _ALLOC_STATS_H_
+#define _ALLOC_STATS_H_
+
+#include <iostream>
+#include <string>
+
+#include <stdint.h>
+
+// Heap activity of one kernel invocation
+struct allocReport
+{
+  bool valid;                       // False when the instrumentation is not compiled in
+  uint64_t allocations;             // Number of malloc/calloc/realloc/memalign calls
+  uint64_t bytes;                   // Bytes handed out by those calls
+  int64_t peakHeapBytes;            // Peak of live heap bytes above the level at the start
+  long peakRssDeltaKb;              // Peak resident set size above the RSS at the start
+
+  allocReport() : valid(false), allocations(0), bytes(0), peakHeapBytes(0), peakRssDeltaKb(0) {}
+};
+
+#ifdef ALLOC_STATS
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <malloc.h>
+#include <unistd.h>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+}
+
+static std::atomic<uint64_t> allocCount(0);
+static std::atomic<uint64_t> allocBytes(0);
+static std::atomic<int64_t> liveBytes(0);
+static std::atomic<int64_t> peakLiveBytes(0);
+
+static inline void countAllocation(void *ptr)
+{
+  if(ptr == NULL)
+    return;
+  int64_t size = malloc_usable_size(ptr);
+  allocCount++;
+  allocBytes += size;
+  int64_t live = (liveBytes += size);
+  int64_t peak = peakLiveBytes.load();
+  while(live > peak && !peakLiveBytes.compare_exchange_weak(peak, live))
+    ;
+}
+
+static inline void countRelease(void *ptr)
+{
+  if(ptr != NULL)
+    liveBytes -= (int64_t)malloc_usable_size(ptr);
+}
+
+extern "C" {
+
+void *malloc(size_t size)
+{
+  void *ptr = __libc_malloc(size);
+  countAllocation(ptr);
+  return ptr;
+}
+
+void *calloc(size_t count, size_t size)
+{
+  void *ptr = __libc_calloc(count, size);
+  countAllocation(ptr);
+  return ptr;
+}
+
+void *realloc(void *old, size_t size)
+{
+  countRelease(old);
+  void *ptr = __libc_realloc(old, size);
+  if(ptr == NULL && old != NULL && size != 0)
+  {
+    liveBytes += (int64_t)malloc_usable_size(old);  // Failed: the old block is still alive
+    return NULL;
+  }
+  countAllocation(ptr);
+  return ptr;
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+  void *ptr = __libc_memalign(alignment, size);
+  countAllocation(ptr);
+  return ptr;
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+  return memalign(alignment, size);
+}
+
+int posix_memalign(void **result, size_t alignment, size_t size)
+{
+  if(alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+    return EINVAL;
+  void *ptr = memalign(alignment, size);
+  if(ptr == NULL)
+    return ENOMEM;
+  *result = ptr;
+  return 0;
+}
+
+void free(void *ptr)
+{
+  countRelease(ptr);
+  __libc_free(ptr);
+}
+
+}
+
+// Reads "<field>: <value> kB" from /proc/self/status without allocating (-1 if unavailable)
+inline long procStatusKb(const char *field)
+{
+  char buffer[4096];
+  int fd = open("/proc/self/status", O_RDONLY);
+  if(fd < 0)
+    return -1;
+  ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+  close(fd);
+  if(length <= 0)
+    return -1;
+  buffer[length] = '\0';
+
+  const char *line = strstr(buffer, field);
+  return (line == NULL) ? -1 : strtol(line + strlen(field), NULL, 10);
+}
+
+// Resets the peak RSS (VmHWM) of the process, available since Linux 4.0
+inline void resetPeakRss()
+{
+  int fd = open("/proc/self/clear_refs", O_WRONLY);
+  if(fd >= 0)
+  {
+    ssize_t written = write(fd, "5", 1);   // Older kernels refuse it: the peak then covers the process life
+    (void)written;
+    close(fd);
+  }
+}
+
+/*
+ * Measures the heap activity between its construction and stop()
+ */
+class allocScope
+{
+public:
+  allocScope()
+  {
+    resetPeakRss();
+    startRss_ = procStatusKb("VmRSS:");
+    startCount_ = allocCount.load();
+    startBytes_ = allocBytes.load();
+    startLive_ = liveBytes.load();
+    peakLiveBytes.store(startLive_);
+  }
+
+  allocReport stop() const
+  {
+    allocReport report;
+    report.valid = true;
+    report.allocations = allocCount.load() - startCount_;
+    report.bytes = allocBytes.load() - startBytes_;
+    report.peakHeapBytes = peakLiveBytes.load() - startLive_;
+    long peakRss = procStatusKb("VmHWM:");
+    report.peakRssDeltaKb = (peakRss >= 0 && startRss_ >= 0) ? peakRss - startRss_ : 0;
+    return report;
+  }
+
+private:
+  long startRss_;
+  uint64_t startCount_;
+  uint64_t startBytes_;
+  int64_t startLive_;
+};
+
+#else
+
+class allocScope
+{
+public:
+  allocReport stop() const { return allocReport(); }
+};
+
+#endif
+
+inline void printAllocs(const std::string &label, const allocReport &report)
+{
+  if(report.valid)
+    std::cout << label << " Allocations = " << report.allocations << " (" << report.bytes << " bytes, peak heap +"
+              << report.peakHeapBytes << " bytes, peak RSS +" << report.peakRssDeltaKb << " kB)" << std::endl;
+}
+
+#endif
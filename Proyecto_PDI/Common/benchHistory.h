@@ -0,0 +1,146 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Benchmark History: results of every run appended to a local store keyed by git revision and machine
+*
+* One line per (run, record):
+* git_revision,machine,timestamp,backend,operation,se_size,width,height,cache_mode,bit_exact,
+* allocations,alloc_bytes,peak_heap_bytes,peak_rss_delta_kb,image,samples_ms
+* (the allocation fields are empty unless the version was built with ALLOCSTATS=yes)
+**************************************************************************************************************/
+
+#ifndef _BENCH_HISTORY_H_
+#define _BENCH_HISTORY_H_
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchResults.h"
+
+#define HISTORY_FILE "../history.csv"   // Shared by all versions (relative to each version folder)
+
+struct historyEntry
+{
+  std::string revision;
+  std::string machine;
+  std::string timestamp;
+  benchRecord record;
+};
+
+// Split one CSV line, honouring the quoting done by csvField()
+inline std::vector<std::string> splitCsv(const std::string &line)
+{
+  std::vector<std::string> fields;
+  std::string field;
+  bool quoted = false;
+  for(size_t i = 0; i < line.size(); i++)
+  {
+    char c = line[i];
+    if(quoted)
+    {
+      if(c == '"' && i + 1 < line.size() && line[i + 1] == '"')
+      {
+        field += '"';
+        i++;
+      }
+      else if(c == '"')
+        quoted = false;
+      else
+        field += c;
+    }
+    else if(c == '"')
+      quoted = true;
+    else if(c == ',')
+    {
+      fields.push_back(field);
+      field.clear();
+    }
+    else
+      field += c;
+  }
+  fields.push_back(field);
+  return fields;
+}
+
+// Append every record of a run to the history store, creating it (with its header) if needed
+inline bool appendHistory(const std::string &path, const benchResults &results)
+{
+  bool exists = std::ifstream(path.c_str()).good();
+  std::ofstream out(path.c_str(), std::ios::app);
+  if(!out)
+    return false;
+
+  if(!exists)
+    out << "#git_revision,machine,timestamp,backend,operation,se_size,width,height,cache_mode,bit_exact,"
+        << "allocations,alloc_bytes,peak_heap_bytes,peak_rss_delta_kb,image,samples_ms\n";
+
+  const runMetadata &meta = results.metadata();
+  const std::vector<benchRecord> &records = results.records();
+  for(size_t i = 0; i < records.size(); i++)
+  {
+    const benchRecord &r = records[i];
+    std::string samples;
+    for(size_t j = 0; j < r.samples.size(); j++)
+      samples += (j == 0 ? "" : ";") + formatMs(r.samples[j]);
+
+    out << meta.gitRevision << "," << meta.machine << "," << meta.timestamp << ","
+        << csvField(r.backend) << "," << r.operation << "," << r.seSize << "," << r.width << ","
+        << r.height << "," << r.cacheMode << "," << (r.bitExact ? 1 : 0) << ","
+        << allocFields(r.allocs) << "," << csvField(r.image) << "," << samples << "\n";
+  }
+  return out.good();
+}
+
+// Load the whole store (malformed lines are skipped)
+inline std::vector<historyEntry> loadHistory(const std::string &path)
+{
+  std::vector<historyEntry> entries;
+  std::ifstream in(path.c_str());
+  std::string line;
+  while(std::getline(in, line))
+  {
+    if(line.empty() || line[0] == '#')
+      continue;
+    std::vector<std::string> f = splitCsv(line);
+    if(f.size() == 12)                                      // Written before the allocation fields existed
+      f.insert(f.begin() + 10, 4, std::string());
+    if(f.size() != 16)
+      continue;
+
+    historyEntry entry;
+    entry.revision = f[0];
+    entry.machine = f[1];
+    entry.timestamp = f[2];
+    entry.record.backend = f[3];
+    entry.record.operation = f[4];
+    entry.record.seSize = std::atoi(f[5].c_str());
+    entry.record.width = std::atoi(f[6].c_str());
+    entry.record.height = std::atoi(f[7].c_str());
+    entry.record.cacheMode = f[8];
+    entry.record.bitExact = (f[9] == "1");
+    entry.record.passes = 0;
+    entry.record.bytesPerPixel = 0;
+    entry.record.allocs.valid = !f[10].empty();
+    entry.record.allocs.allocations = std::strtoull(f[10].c_str(), NULL, 10);
+    entry.record.allocs.bytes = std::strtoull(f[11].c_str(), NULL, 10);
+    entry.record.allocs.peakHeapBytes = std::strtoll(f[12].c_str(), NULL, 10);
+    entry.record.allocs.peakRssDeltaKb = std::strtol(f[13].c_str(), NULL, 10);
+    entry.record.image = f[14];
+
+    std::stringstream samples(f[15]);
+    std::string ms;
+    while(std::getline(samples, ms, ';'))
+      entry.record.samples.push_back(std::atof(ms.c_str()) / 1000.0);
+    entries.push_back(entry);
+  }
+  return entries;
+}
+
+#endif
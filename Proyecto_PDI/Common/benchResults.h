@@ -0,0 +1,419 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Benchmark Results: CSV/JSON writer with run metadata (shared by all versions)
+*
+* The files are streamed directly with std::ofstream. The CSV keeps the metadata as '#' comment lines so
+* that gnuplot can read it as-is (see results_min.plt / results_max.plt).
+**************************************************************************************************************/
+
+#ifndef _BENCH_RESULTS_H_
+#define _BENCH_RESULTS_H_
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include "allocStats.h"
+#include "roofline.h"
+
+// Compiler flags are injected by the Makefiles, fall back to what the preprocessor knows
+#ifndef BENCH_CXXFLAGS
+#define BENCH_CXXFLAGS "unknown"
+#endif
+
+// Information about the machine and the build that produced the results
+struct runMetadata
+{
+  std::string machine;              // Fingerprint of host name, CPU model and core count
+  std::string cpuModel;
+  unsigned int cores;
+  std::string compiler;
+  std::string compilerFlags;
+  std::string gitRevision;
+  std::string timestamp;
+};
+
+// One timing point: a backend applying one operation with one SE on one image
+struct benchRecord
+{
+  std::string backend;
+  std::string operation;            // "min" (erosion) or "max" (dilation)
+  std::string image;
+  int width;
+  int height;
+  int seSize;
+  std::string cacheMode;            // "cold": clearCache.sh before each sample, "warm": no flush
+  bool bitExact;                    // Output identical to the reference filter (see morphOracle.h)
+  int passes;                       // Passes over the image, for the roofline model (see roofline.h)
+  double bytesPerPixel;             // Minimum traffic per pixel: 2 per pass unless the kernel gives its own
+  allocReport allocs;               // Heap activity of one invocation (see allocStats.h)
+  std::vector<double> samples;      // Raw samples in seconds
+};
+
+
+// Trim leading/trailing blanks
+inline std::string trimBlanks(const std::string &str)
+{
+  const char *blanks = " \t\r\n";
+  std::string::size_type first = str.find_first_not_of(blanks);
+  if(first == std::string::npos)
+    return "";
+  std::string::size_type last = str.find_last_not_of(blanks);
+  return str.substr(first, last - first + 1);
+}
+
+// First line of a small text file ("" if it cannot be read)
+inline std::string readFirstLine(const std::string &path)
+{
+  std::ifstream file(path.c_str());
+  std::string line;
+  if(file)
+    std::getline(file, line);
+  return trimBlanks(line);
+}
+
+// CPU model from /proc/cpuinfo (x86 uses "model name", ARM boards use "Hardware" or "CPU part")
+inline std::string readCpuModel()
+{
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  std::string fallback = "unknown";
+  while(std::getline(cpuinfo, line))
+  {
+    std::string::size_type sep = line.find(':');
+    if(sep == std::string::npos)
+      continue;
+    std::string key = trimBlanks(line.substr(0, sep));
+    std::string value = trimBlanks(line.substr(sep + 1));
+    if(key == "model name" || key == "Hardware")
+      return value;
+    if(key == "CPU part" && fallback == "unknown")
+      fallback = "CPU part " + value;
+  }
+  return fallback;
+}
+
+// Git revision read from the .git directory of the nearest parent folder (no shell-outs)
+inline std::string readGitRevision()
+{
+  char cwd[4096];
+  if(getcwd(cwd, sizeof(cwd)) == NULL)
+    return "unknown";
+
+  std::string dir(cwd);
+  while(!dir.empty())
+  {
+    std::string gitDir = dir + "/.git";
+    std::string head = readFirstLine(gitDir + "/HEAD");
+    if(!head.empty())
+    {
+      if(head.compare(0, 5, "ref: ") != 0)
+        return head;                                            // Detached HEAD
+
+      std::string ref = head.substr(5);
+      std::string rev = readFirstLine(gitDir + "/" + ref);
+      if(!rev.empty())
+        return rev;
+
+      std::ifstream packed((gitDir + "/packed-refs").c_str());  // Ref may only live in packed-refs
+      std::string line;
+      while(std::getline(packed, line))
+      {
+        std::string::size_type sep = line.find(' ');
+        if(sep != std::string::npos && trimBlanks(line.substr(sep + 1)) == ref)
+          return line.substr(0, sep);
+      }
+      return "unknown";
+    }
+    dir = dir.substr(0, dir.rfind('/'));
+  }
+  return "unknown";
+}
+
+// FNV-1a hash of the host name, CPU model and core count: results are only comparable on the same machine
+inline std::string machineFingerprint(const std::string &cpuModel, unsigned int cores)
+{
+  char host[256] = "";
+  gethostname(host, sizeof(host) - 1);
+  std::string key = std::string(host) + "|" + cpuModel + "|" + std::to_string(cores);
+
+  uint64_t hash = 1469598103934665603ULL;
+  for(size_t i = 0; i < key.size(); i++)
+  {
+    hash ^= (unsigned char)key[i];
+    hash *= 1099511628211ULL;
+  }
+  char hex[17];
+  std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+  return hex;
+}
+
+inline runMetadata collectMetadata()
+{
+  runMetadata meta;
+  meta.cpuModel = readCpuModel();
+  meta.cores = std::thread::hardware_concurrency();
+  meta.machine = machineFingerprint(meta.cpuModel, meta.cores);
+  #ifdef __VERSION__
+  meta.compiler = __VERSION__;
+  #else
+  meta.compiler = "unknown";
+  #endif
+  meta.compilerFlags = BENCH_CXXFLAGS;
+  meta.gitRevision = readGitRevision();
+
+  char stamp[32];
+  std::time_t now = std::time(NULL);
+  std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+  meta.timestamp = stamp;
+  return meta;
+}
+
+
+/*
+ * Statistics over the raw samples (same population variance as getVariance())
+ */
+inline double sampleMean(const std::vector<double> &samples)
+{
+  double sum = 0.0;
+  for(size_t i = 0; i < samples.size(); i++)
+    sum += samples[i];
+  return samples.empty() ? 0.0 : sum / samples.size();
+}
+
+inline double sampleVariance(const std::vector<double> &samples)
+{
+  double avg = sampleMean(samples);
+  double result = 0.0;
+  for(size_t i = 0; i < samples.size(); i++)
+    result += (avg - samples[i]) * (avg - samples[i]);
+  return samples.empty() ? 0.0 : result / samples.size();
+}
+
+inline double sampleMin(const std::vector<double> &samples)
+{
+  return samples.empty() ? 0.0 : *std::min_element(samples.begin(), samples.end());
+}
+
+
+/*
+ * Field escaping
+ */
+inline std::string csvField(const std::string &str)
+{
+  if(str.find_first_of(",\"\n\r") == std::string::npos)
+    return str;
+  std::string result = "\"";
+  for(size_t i = 0; i < str.size(); i++)
+  {
+    if(str[i] == '"')
+      result += '"';
+    result += str[i];
+  }
+  return result + "\"";
+}
+
+inline std::string jsonString(const std::string &str)
+{
+  std::string result = "\"";
+  for(size_t i = 0; i < str.size(); i++)
+  {
+    unsigned char c = str[i];
+    switch(c)
+    {
+      case '"':  result += "\\\""; break;
+      case '\\': result += "\\\\"; break;
+      case '\n': result += "\\n";  break;
+      case '\r': result += "\\r";  break;
+      case '\t': result += "\\t";  break;
+      default:
+        if(c < 0x20)
+        {
+          char esc[8];
+          std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+          result += esc;
+        }
+        else
+          result += c;
+    }
+  }
+  return result + "\"";
+}
+
+// allocations,alloc_bytes,peak_heap_bytes,peak_rss_delta_kb (empty when not measured)
+inline std::string allocFields(const allocReport &allocs)
+{
+  if(!allocs.valid)
+    return ",,,";
+  return std::to_string(allocs.allocations) + "," + std::to_string(allocs.bytes) + "," +
+         std::to_string(allocs.peakHeapBytes) + "," + std::to_string(allocs.peakRssDeltaKb);
+}
+
+inline std::string formatMs(double seconds)
+{
+  std::ostringstream out;
+  out.precision(9);
+  out << seconds * 1000.0;
+  return out.str();
+}
+
+
+/*
+ * Results of one benchmark run
+ */
+class benchResults
+{
+public:
+  benchResults(const std::string &backend, int passes)
+    : backend_(backend), passes_(passes), meta_(collectMetadata())
+  {
+  }
+
+  void add(const std::string &operation, const std::string &image, int width, int height,
+           int seSize, const std::string &cacheMode, bool bitExact, const std::vector<double> &samples,
+           const allocReport &allocs = allocReport(), double bytesPerPixel = 0)
+  {
+    benchRecord record;
+    record.backend = backend_;
+    record.operation = operation;
+    record.image = image;
+    record.width = width;
+    record.height = height;
+    record.seSize = seSize;
+    record.cacheMode = cacheMode;
+    record.bitExact = bitExact;
+    record.passes = passes_;
+    record.bytesPerPixel = (bytesPerPixel > 0) ? bytesPerPixel : passBytesPerPixel(passes_);
+    record.allocs = allocs;
+    record.samples = samples;
+    records_.push_back(record);
+  }
+
+  const std::vector<benchRecord> &records() const { return records_; }
+  const runMetadata &metadata() const { return meta_; }
+
+  // Rows grouped by operation, so each gnuplot curve is a contiguous run of points
+  std::vector<benchRecord> sortedRecords() const
+  {
+    std::vector<benchRecord> sorted(records_);
+    std::stable_sort(sorted.begin(), sorted.end(), byOperation);
+    return sorted;
+  }
+
+  bool writeCsv(const std::string &path) const
+  {
+    std::ofstream out(path.c_str());
+    if(!out)
+      return false;
+
+    out << "# machine: " << meta_.machine << "\n"
+        << "# cpu_model: " << meta_.cpuModel << "\n"
+        << "# cores: " << meta_.cores << "\n"
+        << "# compiler: " << meta_.compiler << "\n"
+        << "# compiler_flags: " << meta_.compilerFlags << "\n"
+        << "# git_revision: " << meta_.gitRevision << "\n"
+        << "# timestamp: " << meta_.timestamp << "\n"
+        << "# triad_gbps: " << triadBandwidth() << "\n"
+        << "# cpu_frequency_mhz: " << cpuFrequency() / 1e6 << "\n"
+        << "#backend,operation,se_size,width,height,cache_mode,mean_ms,min_ms,variance_ms2,bit_exact,"
+        << "passes,gbps,pixels_per_cycle,roofline_pct,allocations,alloc_bytes,peak_heap_bytes,peak_rss_delta_kb,"
+        << "image,samples_ms\n";
+
+    std::vector<benchRecord> sorted = sortedRecords();
+    for(size_t i = 0; i < sorted.size(); i++)
+    {
+      const benchRecord &r = sorted[i];
+      rooflinePoint point = roofline(r.width, r.height, r.bytesPerPixel, sampleMean(r.samples));
+      std::string samples;
+      for(size_t j = 0; j < r.samples.size(); j++)
+        samples += (j == 0 ? "" : ";") + formatMs(r.samples[j]);
+
+      out << csvField(r.backend) << "," << r.operation << "," << r.seSize << ","
+          << r.width << "," << r.height << "," << r.cacheMode << ","
+          << formatMs(sampleMean(r.samples)) << "," << formatMs(sampleMin(r.samples)) << ","
+          << sampleVariance(r.samples) * 1e6 << "," << (r.bitExact ? 1 : 0) << ","
+          << r.passes << "," << point.gbps << "," << point.pixelsPerCycle << "," << point.percent << ","
+          << allocFields(r.allocs) << ","
+          << csvField(r.image) << "," << samples << "\n";
+    }
+    return out.good();
+  }
+
+  bool writeJson(const std::string &path) const
+  {
+    std::ofstream out(path.c_str());
+    if(!out)
+      return false;
+
+    out << "{\n  \"metadata\": {\n"
+        << "    \"machine\": " << jsonString(meta_.machine) << ",\n"
+        << "    \"cpu_model\": " << jsonString(meta_.cpuModel) << ",\n"
+        << "    \"cores\": " << meta_.cores << ",\n"
+        << "    \"compiler\": " << jsonString(meta_.compiler) << ",\n"
+        << "    \"compiler_flags\": " << jsonString(meta_.compilerFlags) << ",\n"
+        << "    \"git_revision\": " << jsonString(meta_.gitRevision) << ",\n"
+        << "    \"timestamp\": " << jsonString(meta_.timestamp) << ",\n"
+        << "    \"triad_gbps\": " << triadBandwidth() << ",\n"
+        << "    \"cpu_frequency_mhz\": " << cpuFrequency() / 1e6 << "\n"
+        << "  },\n  \"records\": [";
+
+    std::vector<benchRecord> sorted = sortedRecords();
+    for(size_t i = 0; i < sorted.size(); i++)
+    {
+      const benchRecord &r = sorted[i];
+      rooflinePoint point = roofline(r.width, r.height, r.bytesPerPixel, sampleMean(r.samples));
+      out << (i == 0 ? "\n" : ",\n")
+          << "    {\"backend\": " << jsonString(r.backend)
+          << ", \"operation\": " << jsonString(r.operation)
+          << ", \"se_size\": " << r.seSize
+          << ", \"width\": " << r.width
+          << ", \"height\": " << r.height
+          << ", \"cache_mode\": " << jsonString(r.cacheMode)
+          << ", \"image\": " << jsonString(r.image)
+          << ", \"mean_ms\": " << formatMs(sampleMean(r.samples))
+          << ", \"min_ms\": " << formatMs(sampleMin(r.samples))
+          << ", \"variance_ms2\": " << sampleVariance(r.samples) * 1e6
+          << ", \"bit_exact\": " << (r.bitExact ? "true" : "false")
+          << ", \"passes\": " << r.passes
+          << ", \"gbps\": " << point.gbps
+          << ", \"pixels_per_cycle\": " << point.pixelsPerCycle
+          << ", \"roofline_pct\": " << point.percent
+          << ", \"allocations\": " << (r.allocs.valid ? std::to_string(r.allocs.allocations) : "null")
+          << ", \"alloc_bytes\": " << (r.allocs.valid ? std::to_string(r.allocs.bytes) : "null")
+          << ", \"peak_heap_bytes\": " << (r.allocs.valid ? std::to_string(r.allocs.peakHeapBytes) : "null")
+          << ", \"peak_rss_delta_kb\": " << (r.allocs.valid ? std::to_string(r.allocs.peakRssDeltaKb) : "null")
+          << ", \"samples_ms\": [";
+      for(size_t j = 0; j < r.samples.size(); j++)
+        out << (j == 0 ? "" : ", ") << formatMs(r.samples[j]);
+      out << "]}";
+    }
+    out << "\n  ]\n}\n";
+    return out.good();
+  }
+
+private:
+  static bool byOperation(const benchRecord &a, const benchRecord &b)
+  {
+    return a.operation > b.operation;               // "min" rows before "max" rows
+  }
+
+  std::string backend_;
+  int passes_;
+  runMetadata meta_;
+  std::vector<benchRecord> records_;
+};
+
+#endif
@@ -0,0 +1,69 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Bounded Queue: blocking FIFO between the stages of a pipeline
+*
+* push() blocks while the queue is full, so a fast stage cannot run ahead of a slow one and the images in
+* flight are bounded by the queue depths. Once the producers are done the queue is closed: pop() drains
+* what is left and then returns false to every consumer.
+**************************************************************************************************************/
+
+#ifndef _BOUNDED_QUEUE_H_
+#define _BOUNDED_QUEUE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+template<class T>
+class boundedQueue
+{
+public:
+  explicit boundedQueue(size_t capacity) : capacity_(capacity), closed_(false) {}
+
+  void push(const T &item)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    notFull_.wait(lock, [this] { return items_.size() < capacity_ || closed_; });
+    items_.push_back(item);
+    notEmpty_.notify_one();
+  }
+
+  // Blocks until an item arrives; false once the queue is closed and empty
+  bool pop(T &item)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    notEmpty_.wait(lock, [this] { return !items_.empty() || closed_; });
+    if(items_.empty())
+      return false;
+    item = items_.front();
+    items_.pop_front();
+    notFull_.notify_one();
+    return true;
+  }
+
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    notEmpty_.notify_all();
+    notFull_.notify_all();
+  }
+
+private:
+  boundedQueue(const boundedQueue &);
+  boundedQueue &operator=(const boundedQueue &);
+
+  size_t capacity_;
+  bool closed_;
+  std::deque<T> items_;
+  std::mutex mutex_;
+  std::condition_variable notEmpty_;
+  std::condition_variable notFull_;
+};
+
+#endif
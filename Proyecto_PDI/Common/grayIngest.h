@@ -0,0 +1,166 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Gray Ingestion: loads the input images straight as 8-bit gray
+*
+* Binary PGM files (and raw files of a given size) are memory-mapped and their rows are used in place, with
+* no decode and no copy. Any other format goes through a decoder supplied by the program (the LTI-Lib or
+* OpenCV loader), which must produce gray rows directly. grayPrefetcher walks a list of files and decodes
+* the next one on a background thread while the caller filters the current one.
+**************************************************************************************************************/
+
+#ifndef _GRAY_INGEST_H_
+#define _GRAY_INGEST_H_
+
+#include <algorithm>
+#include <cctype>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mappedImage.h"
+#include "morphOracle.h"
+
+// Decodes path into gray; on failure returns false and describes the problem in error
+typedef bool (*grayDecoder)(const std::string &path, grayBuffer &gray, std::string &error);
+
+// Read-only gray rows, with the same rows/cols/operator[] interface as grayBuffer
+struct grayView
+{
+  const uint8_t *data;
+  int rows;
+  int cols;
+  ptrdiff_t stride;
+
+  const uint8_t *operator[](int y) const { return data + y * stride; }
+};
+
+inline bool isPgmFile(const std::string &path)
+{
+  size_t dot = path.find_last_of('.');
+  if(dot == std::string::npos || path.find('/', dot) != std::string::npos)
+    return false;
+  std::string extension = path.substr(dot + 1);
+  std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+  return extension == "pgm";
+}
+
+class grayInput
+{
+public:
+  grayInput() : mapped_(false) {}
+
+  /*
+   * PGM files, or raw files when rawRows > 0, are mapped; anything else is decoded. decoder may be NULL if
+   * only mapped inputs are expected.
+   */
+  bool open(const std::string &path, grayDecoder decoder, int rawRows = 0, int rawCols = 0)
+  {
+    path_ = path;
+    error_.clear();
+    decoded_ = grayBuffer();
+    mapped_ = (rawRows > 0 || isPgmFile(path));
+    if(mapped_)
+    {
+      if(map_.openRead(path, rawRows, rawCols))
+        return true;
+      error_ = map_.error();
+      return false;
+    }
+    map_.close();
+    if(decoder == NULL)
+    {
+      error_ = "no decoder for " + path;
+      return false;
+    }
+    return decoder(path, decoded_, error_);
+  }
+
+  int rows() const { return mapped_ ? map_.rows() : decoded_.rows; }
+  int cols() const { return mapped_ ? map_.cols() : decoded_.cols; }
+  bool mapped() const { return mapped_; }
+  const std::string &path() const { return path_; }
+  const std::string &error() const { return error_; }
+
+  // The pixels in place: the mapped file or the decoded buffer
+  grayView view() const
+  {
+    grayView v = { mapped_ ? map_.row(0) : decoded_.pixels.data(), rows(), cols(), cols() };
+    return v;
+  }
+
+  // For the kernels that need their own grayBuffer (the planner candidates)
+  void copyTo(grayBuffer &buf) const
+  {
+    if(!mapped_)
+    {
+      buf = decoded_;
+      return;
+    }
+    buf = grayBuffer(rows(), cols());
+    for(int y = 0; y < rows(); y++)
+      std::copy(map_.row(y), map_.row(y) + cols(), buf[y]);
+  }
+
+private:
+  grayInput(const grayInput &);
+  grayInput &operator=(const grayInput &);
+
+  std::string path_;
+  std::string error_;
+  bool mapped_;
+  mappedImage map_;
+  grayBuffer decoded_;
+};
+
+class grayPrefetcher
+{
+public:
+  grayPrefetcher(const std::vector<std::string> &paths, grayDecoder decoder)
+    : paths_(paths), decoder_(decoder), next_(0)
+  {
+    launch();
+  }
+
+  /*
+   * The next image in list order, or NULL after the last one. It is returned even if it failed to load
+   * (check error()). The following image starts loading before this returns.
+   */
+  std::shared_ptr<grayInput> next()
+  {
+    if(!pending_.valid())
+      return std::shared_ptr<grayInput>();
+    std::shared_ptr<grayInput> image = pending_.get();
+    launch();
+    return image;
+  }
+
+private:
+  static std::shared_ptr<grayInput> load(std::string path, grayDecoder decoder)
+  {
+    std::shared_ptr<grayInput> image(new grayInput());
+    image->open(path, decoder);
+    return image;
+  }
+
+  void launch()
+  {
+    if(next_ < paths_.size())
+      pending_ = std::async(std::launch::async, load, paths_[next_++], decoder_);
+  }
+
+  std::vector<std::string> paths_;
+  grayDecoder decoder_;
+  size_t next_;
+  std::future< std::shared_ptr<grayInput> > pending_;
+};
+
+#endif
@@ -0,0 +1,206 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Memory-Mapped Images: 8-bit gray images in raw or binary PGM (P5) files accessed through mmap, so images
+* larger than the RAM can be processed row band by row band
+**************************************************************************************************************/
+
+#ifndef _MAPPED_IMAGE_H_
+#define _MAPPED_IMAGE_H_
+
+#include <cctype>
+#include <cstdio>
+#include <string>
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class mappedImage
+{
+public:
+  mappedImage() : fd_(-1), base_(NULL), size_(0), offset_(0), rows_(0), cols_(0), writable_(false) {}
+  ~mappedImage() { close(); }
+
+  /*
+   * Maps an existing file for reading. With rows == 0 the file must be a binary PGM (the size comes from
+   * its header); otherwise it is read as raw rows x cols bytes.
+   */
+  bool openRead(const std::string &path, int rows = 0, int cols = 0)
+  {
+    close();
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if(fd_ < 0)
+      return fail("cannot open " + path);
+    struct stat info;
+    if(fstat(fd_, &info) != 0)
+      return fail("cannot stat " + path);
+    size_ = info.st_size;
+
+    if(rows == 0)
+    {
+      if(!readPgmHeader())
+        return fail(path + " is not an 8-bit binary PGM (P5) file");
+    }
+    else
+    {
+      rows_ = rows;
+      cols_ = cols;
+      offset_ = 0;
+    }
+    if(size_ < offset_ + (size_t)rows_ * cols_)
+      return fail(path + " is shorter than " + std::to_string(rows_) + "x" + std::to_string(cols_) +
+                  " pixels");
+
+    base_ = (uint8_t *)mmap(NULL, size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if(base_ == MAP_FAILED)
+    {
+      base_ = NULL;
+      return fail("cannot map " + path);
+    }
+    madvise(base_, size_, MADV_SEQUENTIAL);
+    writable_ = false;
+    return true;
+  }
+
+  // Creates (or truncates) a rows x cols file, as a binary PGM when pgm is true, and maps it for writing
+  bool create(const std::string &path, int rows, int cols, bool pgm = true)
+  {
+    close();
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd_ < 0)
+      return fail("cannot create " + path);
+
+    std::string header;
+    if(pgm)
+      header = "P5\n" + std::to_string(cols) + " " + std::to_string(rows) + "\n255\n";
+    rows_ = rows;
+    cols_ = cols;
+    offset_ = header.size();
+    size_ = offset_ + (size_t)rows * cols;
+    if(ftruncate(fd_, size_) != 0)
+      return fail("cannot resize " + path);
+
+    base_ = (uint8_t *)mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if(base_ == MAP_FAILED)
+    {
+      base_ = NULL;
+      return fail("cannot map " + path);
+    }
+    header.copy((char *)base_, header.size());
+    writable_ = true;
+    return true;
+  }
+
+  void close()
+  {
+    if(base_ != NULL)
+    {
+      if(writable_)
+        msync(base_, size_, MS_SYNC);
+      munmap(base_, size_);
+    }
+    if(fd_ >= 0)
+      ::close(fd_);
+    fd_ = -1;
+    base_ = NULL;
+    size_ = 0;
+  }
+
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+  const std::string &error() const { return error_; }
+
+  const uint8_t *row(int y) const { return base_ + offset_ + (size_t)y * cols_; }
+  uint8_t *row(int y) { return base_ + offset_ + (size_t)y * cols_; }
+
+  // Starts writing rows [y0, y1) back to the file (does not wait for the disk)
+  void flush(int y0, int y1)
+  {
+    size_t begin, end;
+    if(writable_ && pageRange(y0, y1, begin, end))
+      msync(base_ + begin, end - begin, MS_ASYNC);
+  }
+
+  // Drops the pages that only hold rows [y0, y1) from the resident set; they are re-read if touched again
+  void release(int y0, int y1) const
+  {
+    size_t begin, end;
+    if(pageRange(y0, y1, begin, end))
+      madvise(base_ + begin, end - begin, MADV_DONTNEED);
+  }
+
+private:
+  mappedImage(const mappedImage &);
+  mappedImage &operator=(const mappedImage &);
+
+  bool fail(const std::string &message)
+  {
+    error_ = message;
+    close();
+    return false;
+  }
+
+  // Whole pages inside rows [y0, y1), as offsets from the start of the mapping
+  bool pageRange(int y0, int y1, size_t &begin, size_t &end) const
+  {
+    if(base_ == NULL || y1 <= y0)
+      return false;
+    size_t page = sysconf(_SC_PAGESIZE);
+    begin = ((offset_ + (size_t)y0 * cols_ + page - 1) / page) * page;
+    end = ((offset_ + (size_t)y1 * cols_) / page) * page;
+    return end > begin;
+  }
+
+  // "P5", width, height and maxval separated by blanks (and # comments), then one blank before the data
+  bool readPgmHeader()
+  {
+    char header[512];
+    ssize_t length = pread(fd_, header, sizeof(header), 0);
+    if(length < 3 || header[0] != 'P' || header[1] != '5')
+      return false;
+
+    long values[3];
+    ssize_t pos = 2;
+    for(int v = 0; v < 3; v++)
+    {
+      while(pos < length && (isspace((unsigned char)header[pos]) || header[pos] == '#'))
+      {
+        if(header[pos] == '#')
+          while(pos < length && header[pos] != '\n')
+            pos++;
+        else
+          pos++;
+      }
+      if(pos >= length || !isdigit((unsigned char)header[pos]))
+        return false;
+      values[v] = 0;
+      while(pos < length && isdigit((unsigned char)header[pos]))
+        values[v] = values[v] * 10 + (header[pos++] - '0');
+    }
+    if(pos >= length || !isspace((unsigned char)header[pos]) || values[2] > 255 || values[2] <= 0)
+      return false;
+
+    cols_ = values[0];
+    rows_ = values[1];
+    offset_ = pos + 1;
+    return true;
+  }
+
+  int fd_;
+  uint8_t *base_;
+  size_t size_;
+  size_t offset_;                   // Header size
+  int rows_;
+  int cols_;
+  bool writable_;
+  std::string error_;
+};
+
+#endif
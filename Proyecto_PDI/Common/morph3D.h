@@ -0,0 +1,219 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Volumetric Morphology: min/max filters over image stacks (CT, confocal) with a cuboid structuring element
+* of seX x seY x seZ voxels, anchored like the 2D filters (at se/2 on every axis)
+*
+* The filter is separable in x, y and z. Each slice is filtered in x (van Herk rows) and in y, and the
+* z-axis is a third van Herk pass over whole slices. The y and z passes share vanHerkStream, which consumes
+* planes (rows or slices) one at a time and emits each output plane as soon as its window is complete, so a
+* stack is processed slice by slice with about 2 * seZ slices resident, whatever its depth.
+**************************************************************************************************************/
+
+#ifndef _MORPH_3D_H_
+#define _MORPH_3D_H_
+
+#include <algorithm>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "morphKernels.h"
+
+// a = a op b over n bytes
+template<class Op>
+inline void combinePlanes(uint8_t *a, const uint8_t *b, size_t n)
+{
+  for(size_t i = 0; i < n; i++)
+    a[i] = Op::apply(a[i], b[i]);
+}
+
+inline void combinePlanes(uint8_t *a, const uint8_t *b, size_t n, morphOperation op)
+{
+  if(op == MorphMin)
+    combinePlanes<morphMinOp>(a, b, n);
+  else
+    combinePlanes<morphMaxOp>(a, b, n);
+}
+
+/*
+ * van Herk/Gil-Werman along a sequence of planes. The sequence is padded with se_size/2 neutral planes in
+ * front and (se_size - 1)/2 behind, and cut into blocks of se_size; g is the running value since the start
+ * of the current block and h (computed when a block is complete) the value up to the end of each block,
+ * so output plane z = h[z] op g[z + se_size - 1] costs three operations per byte for any se_size. Only the
+ * current block, the h of the previous one and g are kept.
+ */
+class vanHerkStream
+{
+public:
+  vanHerkStream() : planeSize_(0), seSize_(0), op_(MorphMin), padded_(0) {}
+
+  void begin(size_t planeSize, int se_size, morphOperation op)
+  {
+    planeSize_ = planeSize;
+    seSize_ = se_size;
+    op_ = op;
+    padded_ = 0;
+    current_.resize(planeSize * se_size);
+    previous_.resize(planeSize * se_size);
+    g_.resize(planeSize);
+    output_.resize(planeSize);
+    for(int i = 0; i < se_size / 2; i++)
+      push(NULL);
+  }
+
+  /*
+   * Adds the next plane (NULL adds a neutral one, to drain after the last plane). Returns true when an
+   * output plane is ready in output(); they come out in order, (se_size - 1)/2 planes behind the input.
+   */
+  bool push(const uint8_t *plane)
+  {
+    int position = padded_ % seSize_;
+    uint8_t *slot = &current_[position * planeSize_];
+    if(plane != NULL)
+      std::copy(plane, plane + planeSize_, slot);
+    else
+      std::fill(slot, slot + planeSize_, (uint8_t)((op_ == MorphMin) ? 255 : 0));
+
+    if(position == 0)
+      std::copy(slot, slot + planeSize_, g_.begin());
+    else
+      combinePlanes(&g_[0], slot, planeSize_, op_);
+
+    if(position == seSize_ - 1)
+    {
+      for(int i = seSize_ - 2; i >= 0; i--)
+        combinePlanes(&current_[i * planeSize_], &current_[(i + 1) * planeSize_], planeSize_, op_);
+      current_.swap(previous_);
+    }
+
+    bool ready = (++padded_ >= seSize_);
+    if(ready)
+    {
+      const uint8_t *h = &previous_[((position + 1) % seSize_) * planeSize_];
+      std::copy(h, h + planeSize_, output_.begin());
+      combinePlanes(&output_[0], &g_[0], planeSize_, op_);
+    }
+    return ready;
+  }
+
+  // Neutral planes still to push after the last input plane
+  int pending() const { return (seSize_ - 1) / 2; }
+
+  const uint8_t *output() const { return &output_[0]; }
+
+private:
+  size_t planeSize_;
+  int seSize_;
+  morphOperation op_;
+  long padded_;                     // Planes pushed so far, padding included
+  std::vector<uint8_t> current_;    // Planes of the block being filled; its h once complete
+  std::vector<uint8_t> previous_;   // h of the last complete block
+  std::vector<uint8_t> g_;
+  std::vector<uint8_t> output_;
+};
+
+/*
+ * Streaming 3D filter: push the slices in order and collect an output slice whenever push() or finish()
+ * returns true. Output slice z is ready once input slice z + (seZ - 1)/2 has been pushed.
+ */
+class morph3D
+{
+public:
+  morph3D() : rows_(0), cols_(0), seX_(1), seY_(1), op_(MorphMin), drain_(0) {}
+
+  void begin(int rows, int cols, int seX, int seY, int seZ, morphOperation op)
+  {
+    rows_ = rows;
+    cols_ = cols;
+    seX_ = seX;
+    seY_ = seY;
+    op_ = op;
+    slice_ = grayBuffer(rows, cols);
+    result_ = grayBuffer(rows, cols);
+    row_.resize(cols);
+    z_.begin((size_t)rows * cols, seZ, op);
+    drain_ = z_.pending();
+  }
+
+  // slice may be a grayBuffer or any row source with operator[] (a grayView of a mapped file)
+  template<class Src>
+  bool push(const Src &slice)
+  {
+    filterSlice(slice);
+    return emit(z_.push(&slice_.pixels[0]));
+  }
+
+  // Drains the last slices: call until it returns false
+  bool finish()
+  {
+    while(drain_ > 0)
+    {
+      drain_--;
+      if(emit(z_.push(NULL)))
+        return true;
+    }
+    return false;
+  }
+
+  const grayBuffer &output() const { return result_; }
+
+private:
+  // x and y passes of one slice into slice_
+  template<class Src>
+  void filterSlice(const Src &slice)
+  {
+    y_.begin(cols_, seY_, op_);
+    int y = 0;
+    for(int r = 0; r < rows_; r++)
+    {
+      if(op_ == MorphMin)
+        vanHerkLine<morphMinOp>(slice[r], cols_, &row_[0], seX_, g_, h_);
+      else
+        vanHerkLine<morphMaxOp>(slice[r], cols_, &row_[0], seX_, g_, h_);
+      if(y_.push(&row_[0]))
+        std::copy(y_.output(), y_.output() + cols_, slice_[y++]);
+    }
+    for(int k = 0; k < y_.pending(); k++)
+      if(y_.push(NULL))
+        std::copy(y_.output(), y_.output() + cols_, slice_[y++]);
+  }
+
+  bool emit(bool ready)
+  {
+    if(ready)
+      std::copy(z_.output(), z_.output() + result_.pixels.size(), result_.pixels.begin());
+    return ready;
+  }
+
+  int rows_, cols_, seX_, seY_;
+  morphOperation op_;
+  int drain_;
+  grayBuffer slice_;                // Current slice after the x and y passes
+  grayBuffer result_;
+  std::vector<uint8_t> row_, g_, h_;
+  vanHerkStream y_, z_;
+};
+
+// Whole stack in memory (each slice rows x cols)
+inline void morphVolume(const std::vector<grayBuffer> &src, std::vector<grayBuffer> &dst, int seX, int seY,
+                        int seZ, morphOperation op)
+{
+  dst.clear();
+  if(src.empty())
+    return;
+  morph3D filter;
+  filter.begin(src[0].rows, src[0].cols, seX, seY, seZ, op);
+  for(size_t z = 0; z < src.size(); z++)
+    if(filter.push(src[z]))
+      dst.push_back(filter.output());
+  while(filter.finish())
+    dst.push_back(filter.output());
+}
+
+#endif
@@ -0,0 +1,101 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Morphology Context: min/max filter that owns its scratch buffers and reuses them across calls
+*
+* The image is streamed row by row: each input row is filtered horizontally (van Herk) into a ring of
+* se_size rows, and every output row combines the se_size ring rows of its window. Output row y is
+* written after input row y + (se_size - 1)/2 has been read, so src and dst may be the same buffer. Once
+* the geometry (columns, SE size) has been seen, a call performs no allocation at all.
+**************************************************************************************************************/
+
+#ifndef _MORPH_CONTEXT_H_
+#define _MORPH_CONTEXT_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "morphKernels.h"
+
+class morphContext
+{
+public:
+  morphContext() : cols_(0), seSize_(0), reallocations_(0) {}
+
+  /*
+   * dst is only reallocated if its size differs from src; &src == &dst is allowed. src may also be any
+   * read-only row source with rows, cols and operator[] (a grayView of a mapped file), read in place.
+   */
+  template<class Src>
+  void apply(const Src &src, grayBuffer &dst, int se_size, morphOperation op)
+  {
+    prepare(src.cols, se_size);
+    if((const void *)&dst != (const void *)&src && (dst.rows != src.rows || dst.cols != src.cols))
+    {
+      dst = grayBuffer(src.rows, src.cols);
+      reallocations_++;
+    }
+    if(op == MorphMin)
+      run<morphMinOp>(src, dst, se_size);
+    else
+      run<morphMaxOp>(src, dst, se_size);
+  }
+
+  // Times the scratch (or an output) had to be allocated: stays constant while the geometry does
+  long reallocations() const { return reallocations_; }
+
+private:
+  void prepare(int cols, int se_size)
+  {
+    if(cols == cols_ && se_size == seSize_)
+      return;
+    cols_ = cols;
+    seSize_ = se_size;
+    ring_.assign((size_t)se_size * cols, 0);
+    int length = ((cols + 2 * (se_size - 1)) / se_size + 1) * se_size;
+    g_.reserve(length);
+    h_.reserve(length);
+    reallocations_++;
+  }
+
+  template<class Op, class Src>
+  void run(const Src &src, grayBuffer &dst, int se_size)
+  {
+    const int before = se_size / 2;
+    const int after = (se_size - 1) / 2;
+    const int rows = src.rows;
+    const int cols = src.cols;
+
+    for(int r = 0; r < rows + after; r++)
+    {
+      if(r < rows)
+        vanHerkLine<Op>(src[r], cols, &ring_[(size_t)(r % se_size) * cols], se_size, g_, h_);
+
+      int y = r - after;
+      if(y < 0)
+        continue;
+      int b0 = std::max(0, y - before), b1 = std::min(rows - 1, y + after);
+      uint8_t *out = dst[y];
+      const uint8_t *first = &ring_[(size_t)(b0 % se_size) * cols];
+      std::copy(first, first + cols, out);
+      for(int b = b0 + 1; b <= b1; b++)
+      {
+        const uint8_t *in = &ring_[(size_t)(b % se_size) * cols];
+        for(int x = 0; x < cols; x++)
+          out[x] = Op::apply(out[x], in[x]);
+      }
+    }
+  }
+
+  int cols_;
+  int seSize_;
+  long reallocations_;
+  std::vector<uint8_t> ring_;       // se_size horizontally filtered rows, row r in slot r % se_size
+  std::vector<uint8_t> g_, h_;      // van Herk scratch of one row
+};
+
+#endif
@@ -0,0 +1,172 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Disk Morphology: exact binary erosion and dilation with a disk of any radius, through the Euclidean
+* distance transform of Felzenszwalb and Huttenlocher
+*
+* The squared distance to the nearest feature pixel is separable: a column pass finds the distance along
+* each column (two scans, done row by row so all columns advance together), and a row pass takes the lower
+* envelope of the parabolas (x - q)^2 + f(q). Both are linear in the pixels whatever the radius, and each is
+* split across threads (strips of columns, then bands of rows). Thresholding gives
+*   dilation: distance to the nearest foreground pixel <= radius
+*   erosion:  distance to the nearest background pixel  > radius
+* Masks are binary (0 is background, anything else foreground) and the result is 0/255. As in the other
+* filters, pixels outside the image are ignored.
+**************************************************************************************************************/
+
+#ifndef _MORPH_DISK_H_
+#define _MORPH_DISK_H_
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "morphOracle.h"
+
+// Runs work(begin, end) over [0, n) split in contiguous ranges, one per thread
+template<class Work>
+void parallelRanges(int n, int threads, Work work)
+{
+  threads = std::max(1, std::min(threads, n));
+  std::vector<std::thread> pool;
+  for(int t = 1; t < threads; t++)
+    pool.push_back(std::thread(work, (int)((long)n * t / threads), (int)((long)n * (t + 1) / threads)));
+  work(0, n / threads);
+  for(size_t t = 0; t < pool.size(); t++)
+    pool[t].join();
+}
+
+inline int defaultThreads()
+{
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Abscissa where the parabolas of q and p (p < q) cross
+inline double edtIntersection(const double *f, int q, int p)
+{
+  return ((f[q] + (double)q * q) - (f[p] + (double)p * p)) / (2.0 * (q - p));
+}
+
+/*
+ * Lower envelope of the parabolas (x - q)^2 + f[q]: d[x] is the squared distance along the row. v and z
+ * (n and n + 1 entries) are scratch: the parabolas of the envelope and the boundaries between them.
+ */
+inline void edtLine(const double *f, int n, double *d, int *v, double *z)
+{
+  int k = 0;
+  v[0] = 0;
+  z[0] = -1e300;
+  z[1] = 1e300;
+  for(int q = 1; q < n; q++)
+  {
+    double s = edtIntersection(f, q, v[k]);
+    while(s <= z[k])                // z[0] stops it: the values of f are finite
+    {
+      k--;
+      s = edtIntersection(f, q, v[k]);
+    }
+    k++;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = 1e300;
+  }
+  k = 0;
+  for(int x = 0; x < n; x++)
+  {
+    while(z[k + 1] < x)
+      k++;
+    double dx = x - v[k];
+    d[x] = dx * dx + f[v[k]];
+  }
+}
+
+/*
+ * Squared Euclidean distance from every pixel to the nearest feature pixel (foreground when toForeground,
+ * background otherwise). Returns false, leaving dist untouched, if the image has no feature pixel.
+ */
+inline bool squaredDistance(const grayBuffer &mask, bool toForeground, std::vector<double> &dist,
+                            int threads = defaultThreads())
+{
+  const int rows = mask.rows;
+  const int cols = mask.cols;
+  const int far = rows + cols;      // Farther than any pixel from a feature pixel of the image
+  std::vector<int> column((size_t)rows * cols);
+
+  // Column pass: distance to the nearest feature above, then below, scanning whole rows
+  parallelRanges(cols, threads, [&](int x0, int x1)
+  {
+    for(int y = 0; y < rows; y++)
+    {
+      const uint8_t *in = mask[y];
+      int *d = &column[(size_t)y * cols];
+      for(int x = x0; x < x1; x++)
+      {
+        bool feature = (in[x] != 0) == toForeground;
+        d[x] = feature ? 0 : (y > 0 ? std::min(d[x - cols] + 1, far) : far);
+      }
+    }
+    for(int y = rows - 2; y >= 0; y--)
+    {
+      int *d = &column[(size_t)y * cols];
+      const int *down = d + cols;
+      for(int x = x0; x < x1; x++)
+        d[x] = std::min(d[x], down[x] + 1);
+    }
+  });
+  bool any = false;
+  for(size_t i = 0; i < column.size() && !any; i++)
+    any = (column[i] == 0);
+  if(!any)
+    return false;
+
+  // Row pass: parabola envelope of the squared column distances
+  dist.resize((size_t)rows * cols);
+  parallelRanges(rows, threads, [&](int y0, int y1)
+  {
+    std::vector<double> f(cols), z(cols + 1);
+    std::vector<int> v(cols);
+    for(int y = y0; y < y1; y++)
+    {
+      const int *c = &column[(size_t)y * cols];
+      for(int x = 0; x < cols; x++)
+        f[x] = (double)c[x] * c[x];
+      edtLine(&f[0], cols, &dist[(size_t)y * cols], &v[0], &z[0]);
+    }
+  });
+  return true;
+}
+
+// Erosion (MorphMin) or dilation (MorphMax) of a binary mask by the disk x^2 + y^2 <= radius^2
+inline void morphDisk(const grayBuffer &src, grayBuffer &dst, int radius, morphOperation op,
+                      int threads = defaultThreads())
+{
+  bool dilate = (op == MorphMax);
+  std::vector<double> dist;
+  dst = grayBuffer(src.rows, src.cols);
+  if(src.rows == 0 || src.cols == 0)
+    return;
+  if(!squaredDistance(src, dilate, dist, threads))
+  {
+    // No foreground to grow (all 0), or no background to erode from (all 255)
+    std::fill(dst.pixels.begin(), dst.pixels.end(), dilate ? 0 : 255);
+    return;
+  }
+  const double limit = (double)radius * radius;
+  for(size_t i = 0; i < dist.size(); i++)
+    dst.pixels[i] = ((dist[i] <= limit) == dilate) ? 255 : 0;
+}
+
+/*
+ * morphBackend adapter: the disk of radius (se_size - 1)/2, the largest that fits in the se_size square
+ * window, so the halos of the other drivers (tiledMorph) hold it
+ */
+inline void morphDiskBackend(const grayBuffer &src, grayBuffer &dst, int se_size, morphOperation op)
+{
+  morphDisk(src, dst, (se_size - 1) / 2, op);
+}
+
+#endif
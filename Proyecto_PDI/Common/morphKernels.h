@@ -0,0 +1,491 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Morphology Kernels: min/max filter implementations on plain gray buffers, candidates for the planner
+*
+* Every kernel follows the reference semantics of morphOracle.h (square SE, anchor at se_size/2, pixels
+* outside the image ignored), so any of them can replace another one without changing the output.
+*
+* Based on:
+* M. van Herk, "A fast algorithm for local minimum and maximum filters on rectangular and octagonal
+* kernels", Pattern Recognition Letters, 1992 (and Gil & Werman, 1993)
+* P. Dokladal, E. Dokladalova, "Computationally efficient, one-pass algorithm for morphological filters",
+* Journal of Visual Communication and Image Representation, 2011
+**************************************************************************************************************/
+
+#ifndef _MORPH_KERNELS_H_
+#define _MORPH_KERNELS_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MORPH_HAVE_NEON 1
+#endif
+
+#include "morphOracle.h"
+
+// Min and max as types, so the inner loops are specialised at compile time
+struct morphMinOp
+{
+  enum { neutral = 255 };
+  static uint8_t apply(uint8_t a, uint8_t b) { return (a < b) ? a : b; }
+  static bool keeps(uint8_t older, uint8_t newer) { return older < newer; }
+};
+
+struct morphMaxOp
+{
+  enum { neutral = 0 };
+  static uint8_t apply(uint8_t a, uint8_t b) { return (a > b) ? a : b; }
+  static bool keeps(uint8_t older, uint8_t newer) { return older > newer; }
+};
+
+
+/*
+ * Brute force 2D window: O(se_size^2) per pixel (what the Serial version does, with the reference anchor)
+ */
+template<class Op>
+void morphNaive(const grayBuffer &src, grayBuffer &dst, int se_size)
+{
+  const int before = se_size / 2;
+  const int after = (se_size - 1) / 2;
+  dst = grayBuffer(src.rows, src.cols);
+  for(int y = 0; y < src.rows; y++)
+  {
+    int b0 = std::max(0, y - before), b1 = std::min(src.rows - 1, y + after);
+    for(int x = 0; x < src.cols; x++)
+    {
+      int a0 = std::max(0, x - before), a1 = std::min(src.cols - 1, x + after);
+      uint8_t value = Op::neutral;
+      for(int b = b0; b <= b1; b++)
+        for(int a = a0; a <= a1; a++)
+          value = Op::apply(value, src[b][a]);
+      dst[y][x] = value;
+    }
+  }
+}
+
+
+/*
+ * Separable: horizontal pass on each row, then a vertical pass that combines whole rows (the inner loop
+ * runs along x, so the compiler can vectorise it). O(se_size) per pixel.
+ */
+template<class Op>
+void morphSeparable(const grayBuffer &src, grayBuffer &dst, int se_size)
+{
+  const int before = se_size / 2;
+  const int after = (se_size - 1) / 2;
+  grayBuffer tmp(src.rows, src.cols);
+  for(int y = 0; y < src.rows; y++)
+  {
+    const uint8_t *in = src[y];
+    uint8_t *out = tmp[y];
+    for(int x = 0; x < src.cols; x++)
+    {
+      uint8_t value = Op::neutral;
+      for(int a = std::max(0, x - before); a <= std::min(src.cols - 1, x + after); a++)
+        value = Op::apply(value, in[a]);
+      out[x] = value;
+    }
+  }
+
+  dst = grayBuffer(src.rows, src.cols);
+  for(int y = 0; y < src.rows; y++)
+  {
+    uint8_t *out = dst[y];
+    std::fill(out, out + src.cols, Op::neutral);
+    for(int b = std::max(0, y - before); b <= std::min(src.rows - 1, y + after); b++)
+    {
+      const uint8_t *in = tmp[b];
+      for(int x = 0; x < src.cols; x++)
+        out[x] = Op::apply(out[x], in[x]);
+    }
+  }
+}
+
+
+/*
+ * van Herk / Gil-Werman: the padded line is cut into blocks of se_size samples; a forward running extreme g
+ * and a backward running extreme h per block give every window with 3 comparisons per pixel, whatever the
+ * SE size. The vertical pass runs on whole rows, like morphSeparable.
+ */
+template<class Op>
+void vanHerkLine(const uint8_t *in, int n, uint8_t *out, int se_size, std::vector<uint8_t> &g,
+                 std::vector<uint8_t> &h)
+{
+  const int before = se_size / 2;
+  const int length = ((n + se_size - 1 + se_size - 1) / se_size) * se_size;   // Padded, whole blocks
+  g.resize(length);
+  h.resize(length);
+  for(int i = 0; i < length; i++)
+  {
+    int x = i - before;
+    g[i] = (x >= 0 && x < n) ? in[x] : (uint8_t)Op::neutral;
+  }
+  h = g;
+  for(int start = 0; start < length; start += se_size)
+  {
+    for(int i = start + 1; i < start + se_size; i++)
+      g[i] = Op::apply(g[i], g[i - 1]);
+    for(int i = start + se_size - 2; i >= start; i--)
+      h[i] = Op::apply(h[i], h[i + 1]);
+  }
+  for(int x = 0; x < n; x++)
+    out[x] = Op::apply(h[x], g[x + se_size - 1]);
+}
+
+template<class Op>
+void morphVanHerk(const grayBuffer &src, grayBuffer &dst, int se_size)
+{
+  const int before = se_size / 2;
+  grayBuffer tmp(src.rows, src.cols);
+  std::vector<uint8_t> g, h;
+  for(int y = 0; y < src.rows; y++)
+    vanHerkLine<Op>(src[y], src.cols, tmp[y], se_size, g, h);
+
+  // Vertical pass: the same recurrences with rows in place of samples
+  const int length = ((src.rows + 2 * (se_size - 1)) / se_size) * se_size;
+  grayBuffer gRows(length, src.cols), hRows(length, src.cols);
+  for(int i = 0; i < length; i++)
+  {
+    int y = i - before;
+    if(y >= 0 && y < src.rows)
+      std::copy(tmp[y], tmp[y] + src.cols, gRows[i]);
+    else
+      std::fill(gRows[i], gRows[i] + src.cols, Op::neutral);
+  }
+  hRows.pixels = gRows.pixels;
+  for(int start = 0; start < length; start += se_size)
+  {
+    for(int i = start + 1; i < start + se_size; i++)
+      for(int x = 0; x < src.cols; x++)
+        gRows[i][x] = Op::apply(gRows[i][x], gRows[i - 1][x]);
+    for(int i = start + se_size - 2; i >= start; i--)
+      for(int x = 0; x < src.cols; x++)
+        hRows[i][x] = Op::apply(hRows[i][x], hRows[i + 1][x]);
+  }
+
+  dst = grayBuffer(src.rows, src.cols);
+  for(int y = 0; y < src.rows; y++)
+    for(int x = 0; x < src.cols; x++)
+      dst[y][x] = Op::apply(hRows[y][x], gRows[y + se_size - 1][x]);
+}
+
+
+/*
+ * Dokladal: one pass per line with a monotone FIFO of candidate positions; every sample is queued and
+ * dequeued once, so the cost does not depend on the SE size either. The FIFO is a ring of se_size + 1 slots.
+ */
+template<class Op>
+void dokladalLine(const uint8_t *in, int n, int inStride, uint8_t *out, int outStride, int se_size,
+                  std::vector<int> &fifo)
+{
+  const int before = se_size / 2;
+  const int after = (se_size - 1) / 2;
+  const int capacity = se_size + 1;
+  fifo.resize(capacity);
+  int head = 0, count = 0;
+
+  for(int i = 0; i < n + after; i++)
+  {
+    if(i < n)
+    {
+      uint8_t value = in[i * inStride];
+      while(count > 0 && !Op::keeps(in[fifo[(head + count - 1) % capacity] * inStride], value))
+        count--;
+      fifo[(head + count) % capacity] = i;
+      count++;
+    }
+    int x = i - after;
+    if(x < 0)
+      continue;
+    while(fifo[head] < x - before)
+    {
+      head = (head + 1) % capacity;
+      count--;
+    }
+    out[x * outStride] = in[fifo[head] * inStride];
+  }
+}
+
+template<class Op>
+void morphDokladal(const grayBuffer &src, grayBuffer &dst, int se_size)
+{
+  grayBuffer tmp(src.rows, src.cols);
+  std::vector<int> fifo;
+  for(int y = 0; y < src.rows; y++)
+    dokladalLine<Op>(src[y], src.cols, 1, tmp[y], 1, se_size, fifo);
+
+  dst = grayBuffer(src.rows, src.cols);
+  for(int x = 0; x < src.cols; x++)
+    dokladalLine<Op>(&tmp.pixels[x], src.rows, src.cols, &dst.pixels[x], src.cols, se_size, fifo);
+}
+
+
+#ifdef MORPH_HAVE_NEON
+/*
+ * NEON separable: the vertical pass combines 16 columns of se_size rows per instruction, the horizontal
+ * pass loads 16 shifted windows from a row padded with the neutral value. Unlike the Neon-Vectorial
+ * version it handles the borders and any width (scalar tail), so it is bit-exact.
+ */
+template<class Op>
+inline uint8x16_t neonApply(uint8x16_t a, uint8x16_t b);
+
+template<>
+inline uint8x16_t neonApply<morphMinOp>(uint8x16_t a, uint8x16_t b) { return vminq_u8(a, b); }
+
+template<>
+inline uint8x16_t neonApply<morphMaxOp>(uint8x16_t a, uint8x16_t b) { return vmaxq_u8(a, b); }
+
+template<class Op>
+void morphNeon(const grayBuffer &src, grayBuffer &dst, int se_size)
+{
+  const int before = se_size / 2;
+  const int after = (se_size - 1) / 2;
+  const int cols = src.cols;
+  grayBuffer tmp(src.rows, cols);
+
+  for(int y = 0; y < src.rows; y++)
+  {
+    const int b0 = std::max(0, y - before), b1 = std::min(src.rows - 1, y + after);
+    int x = 0;
+    for(; x + 16 <= cols; x += 16)
+    {
+      uint8x16_t value = vld1q_u8(&src[b0][x]);
+      for(int b = b0 + 1; b <= b1; b++)
+        value = neonApply<Op>(value, vld1q_u8(&src[b][x]));
+      vst1q_u8(&tmp[y][x], value);
+    }
+    for(; x < cols; x++)
+    {
+      uint8_t value = src[b0][x];
+      for(int b = b0 + 1; b <= b1; b++)
+        value = Op::apply(value, src[b][x]);
+      tmp[y][x] = value;
+    }
+  }
+
+  dst = grayBuffer(src.rows, cols);
+  std::vector<uint8_t> padded(cols + se_size + 16, Op::neutral);
+  for(int y = 0; y < src.rows; y++)
+  {
+    std::copy(tmp[y], tmp[y] + cols, padded.begin() + before);
+    const uint8_t *row = padded.data();
+    int x = 0;
+    for(; x + 16 <= cols; x += 16)
+    {
+      uint8x16_t value = vld1q_u8(row + x);
+      for(int k = 1; k < se_size; k++)
+        value = neonApply<Op>(value, vld1q_u8(row + x + k));
+      vst1q_u8(&dst[y][x], value);
+    }
+    for(; x < cols; x++)
+    {
+      uint8_t value = row[x];
+      for(int k = 1; k < se_size; k++)
+        value = Op::apply(value, row[x + k]);
+      dst[y][x] = value;
+    }
+  }
+}
+#endif
+
+
+/*
+ * 16x16 byte transpose. With NEON the block stays in 16 registers: byte, 16-bit and 32-bit vtrn stages
+ * transpose 2x2, 4x4 and 8x8 sub-blocks, and swapping 64-bit halves completes the 16x16 block. The
+ * scalar fallback keeps the kernel below portable.
+ */
+inline void transpose16x16(const uint8_t *src, ptrdiff_t srcStride, uint8_t *dst, ptrdiff_t dstStride)
+{
+#ifdef MORPH_HAVE_NEON
+  uint8x16_t r[16];
+  for(int i = 0; i < 16; i++)
+    r[i] = vld1q_u8(src + i * srcStride);
+
+  for(int i = 0; i < 16; i += 2)
+  {
+    uint8x16x2_t t = vtrnq_u8(r[i], r[i + 1]);
+    r[i] = t.val[0];
+    r[i + 1] = t.val[1];
+  }
+  for(int i = 0; i < 16; i += 4)
+  {
+    for(int j = i; j < i + 2; j++)
+    {
+      uint16x8x2_t t = vtrnq_u16(vreinterpretq_u16_u8(r[j]), vreinterpretq_u16_u8(r[j + 2]));
+      r[j] = vreinterpretq_u8_u16(t.val[0]);
+      r[j + 2] = vreinterpretq_u8_u16(t.val[1]);
+    }
+  }
+  for(int i = 0; i < 16; i += 8)
+  {
+    for(int j = i; j < i + 4; j++)
+    {
+      uint32x4x2_t t = vtrnq_u32(vreinterpretq_u32_u8(r[j]), vreinterpretq_u32_u8(r[j + 4]));
+      r[j] = vreinterpretq_u8_u32(t.val[0]);
+      r[j + 4] = vreinterpretq_u8_u32(t.val[1]);
+    }
+  }
+  for(int j = 0; j < 8; j++)
+  {
+    uint8x16_t low = r[j], high = r[j + 8];
+    r[j] = vcombine_u8(vget_low_u8(low), vget_low_u8(high));
+    r[j + 8] = vcombine_u8(vget_high_u8(low), vget_high_u8(high));
+  }
+
+  for(int i = 0; i < 16; i++)
+    vst1q_u8(dst + i * dstStride, r[i]);
+#else
+  for(int i = 0; i < 16; i++)
+    for(int j = 0; j < 16; j++)
+      dst[j * dstStride + i] = src[i * srcStride + j];
+#endif
+}
+
+// Transposes a rows x cols buffer (both multiples of 16) into a cols x rows one
+inline void transposeBlocks(const uint8_t *src, int rows, int cols, uint8_t *dst)
+{
+  for(int y = 0; y < rows; y += 16)
+    for(int x = 0; x < cols; x += 16)
+      transpose16x16(src + (size_t)y * cols + x, cols, dst + (size_t)x * rows + y, rows);
+}
+
+/*
+ * Vertical min/max over rows [y - se_size/2, y + (se_size - 1)/2] clamped to [0, validRows), for all
+ * rows x cols of a buffer whose cols is a multiple of 16: whole aligned rows, no unaligned loads.
+ */
+template<class Op>
+void verticalPass(const uint8_t *src, uint8_t *dst, int rows, int cols, int validRows, int se_size)
+{
+  const int before = se_size / 2;
+  const int after = (se_size - 1) / 2;
+  for(int y = 0; y < rows; y++)
+  {
+    int b0 = std::max(0, y - before), b1 = std::min(validRows - 1, y + after);
+    uint8_t *out = dst + (size_t)y * cols;
+    if(b0 > b1)
+    {
+      std::fill(out, out + cols, (uint8_t)Op::neutral);     // Padding row, never read back
+      continue;
+    }
+#ifdef MORPH_HAVE_NEON
+    for(int x = 0; x < cols; x += 16)
+    {
+      uint8x16_t value = vld1q_u8(src + (size_t)b0 * cols + x);
+      for(int b = b0 + 1; b <= b1; b++)
+        value = neonApply<Op>(value, vld1q_u8(src + (size_t)b * cols + x));
+      vst1q_u8(out + x, value);
+    }
+#else
+    std::copy(src + (size_t)b0 * cols, src + (size_t)(b0 + 1) * cols, out);
+    for(int b = b0 + 1; b <= b1; b++)
+    {
+      const uint8_t *in = src + (size_t)b * cols;
+      for(int x = 0; x < cols; x++)
+        out[x] = Op::apply(out[x], in[x]);
+    }
+#endif
+  }
+}
+
+/*
+ * Transposed separable: vertical pass, 16x16 transpose, the same vertical pass on the transposed image
+ * (the horizontal pass of the original one), and transpose back. Every load is a whole aligned row, so
+ * the cost per SE row stays flat where the shifted unaligned loads of morphNeon degrade (large SEs).
+ */
+template<class Op>
+void morphTransposed(const grayBuffer &src, grayBuffer &dst, int se_size)
+{
+  const int rows = ((src.rows + 15) / 16) * 16;
+  const int cols = ((src.cols + 15) / 16) * 16;
+  std::vector<uint8_t> a((size_t)rows * cols, Op::neutral), b(a.size());
+  for(int y = 0; y < src.rows; y++)
+    std::copy(src[y], src[y] + src.cols, &a[(size_t)y * cols]);
+
+  verticalPass<Op>(a.data(), b.data(), rows, cols, src.rows, se_size);
+  transposeBlocks(b.data(), rows, cols, a.data());
+  verticalPass<Op>(a.data(), b.data(), cols, rows, src.cols, se_size);
+  transposeBlocks(b.data(), cols, rows, a.data());
+
+  dst = grayBuffer(src.rows, src.cols);
+  for(int y = 0; y < src.rows; y++)
+    std::copy(&a[(size_t)y * cols], &a[(size_t)y * cols] + src.cols, dst[y]);
+}
+
+/*
+ * Dispatch on the operation, with the signature of a morphBackend (see morphOracle.h)
+ */
+template<template<class> class Kernel>
+void morphDispatch(const grayBuffer &src, grayBuffer &dst, int se_size, morphOperation op)
+{
+  if(op == MorphMin)
+    Kernel<morphMinOp>::run(src, dst, se_size);
+  else
+    Kernel<morphMaxOp>::run(src, dst, se_size);
+}
+
+template<class Op>
+struct naiveKernel
+{
+  static void run(const grayBuffer &src, grayBuffer &dst, int se_size) { morphNaive<Op>(src, dst, se_size); }
+};
+
+template<class Op>
+struct separableKernel
+{
+  static void run(const grayBuffer &src, grayBuffer &dst, int se_size) { morphSeparable<Op>(src, dst, se_size); }
+};
+
+template<class Op>
+struct vanHerkKernel
+{
+  static void run(const grayBuffer &src, grayBuffer &dst, int se_size) { morphVanHerk<Op>(src, dst, se_size); }
+};
+
+template<class Op>
+struct dokladalKernel
+{
+  static void run(const grayBuffer &src, grayBuffer &dst, int se_size) { morphDokladal<Op>(src, dst, se_size); }
+};
+
+template<class Op>
+struct transposedKernel
+{
+  static void run(const grayBuffer &src, grayBuffer &dst, int se_size) { morphTransposed<Op>(src, dst, se_size); }
+};
+
+#ifdef MORPH_HAVE_NEON
+template<class Op>
+struct neonKernel
+{
+  static void run(const grayBuffer &src, grayBuffer &dst, int se_size) { morphNeon<Op>(src, dst, se_size); }
+};
+#endif
+
+// The portable kernels of this header (plus NEON when the target has it), by name
+inline std::vector<std::pair<std::string, morphBackend> > morphKernels()
+{
+  std::vector<std::pair<std::string, morphBackend> > kernels;
+  kernels.push_back(std::make_pair(std::string("naive"), morphBackend(morphDispatch<naiveKernel>)));
+  kernels.push_back(std::make_pair(std::string("separable"), morphBackend(morphDispatch<separableKernel>)));
+  kernels.push_back(std::make_pair(std::string("vanHerk"), morphBackend(morphDispatch<vanHerkKernel>)));
+  kernels.push_back(std::make_pair(std::string("dokladal"), morphBackend(morphDispatch<dokladalKernel>)));
+  kernels.push_back(std::make_pair(std::string("transposed"), morphBackend(morphDispatch<transposedKernel>)));
+#ifdef MORPH_HAVE_NEON
+  kernels.push_back(std::make_pair(std::string("neon"), morphBackend(morphDispatch<neonKernel>)));
+#endif
+  return kernels;
+}
+
+#endif
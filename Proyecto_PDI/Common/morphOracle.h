@@ -0,0 +1,290 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Correctness Oracle: trusted reference min/max filters and cross-implementation verification
+*
+* Reference semantics (the ones every version is checked against):
+*   - Square SE of se_size x se_size pixels, anchor at se_size/2 (OpenCV's default anchor). The window of
+*     pixel x covers [x - se_size/2, x + (se_size - 1)/2], i.e. it is centered for odd sizes.
+*   - Pixels outside the image are ignored (equivalent to padding with 255 for min and 0 for max).
+**************************************************************************************************************/
+
+#ifndef _MORPH_ORACLE_H_
+#define _MORPH_ORACLE_H_
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+enum morphOperation { MorphMin, MorphMax };
+
+inline const char *morphName(morphOperation op)
+{
+  return (op == MorphMin) ? "min" : "max";
+}
+
+// Plain 8-bit gray image, contiguous rows (stride == cols)
+struct grayBuffer
+{
+  int rows;
+  int cols;
+  std::vector<uint8_t> pixels;
+
+  grayBuffer() : rows(0), cols(0) {}
+  grayBuffer(int r, int c, uint8_t value = 0) : rows(r), cols(c), pixels(r * c, value) {}
+
+  uint8_t *operator[](int y) { return &pixels[y * cols]; }
+  const uint8_t *operator[](int y) const { return &pixels[y * cols]; }
+};
+
+// Copy from/to any image type with rows(), columns() and img[y][x] (lti::channel8)
+template<class Img>
+void bufferFromImage(const Img &img, grayBuffer &buf)
+{
+  buf = grayBuffer(img.rows(), img.columns());
+  for(int y = 0; y < buf.rows; y++)
+    for(int x = 0; x < buf.cols; x++)
+      buf[y][x] = img[y][x];
+}
+
+template<class Img>
+void imageFromBuffer(const grayBuffer &buf, Img &img)
+{
+  img.resize(buf.rows, buf.cols, 0);
+  for(int y = 0; y < buf.rows; y++)
+    for(int x = 0; x < buf.cols; x++)
+      img[y][x] = buf[y][x];
+}
+
+
+/*
+ * Reference min/max filter. A square SE is separable, so the reference is a plain horizontal pass followed
+ * by a plain vertical pass: O(se_size) per pixel, exact, and simple enough to be trusted.
+ */
+inline void referenceMorph(const grayBuffer &src, grayBuffer &dst, int se_size, morphOperation op)
+{
+  const int before = se_size / 2;
+  const int after = (se_size - 1) / 2;
+  const uint8_t neutral = (op == MorphMin) ? 255 : 0;
+
+  grayBuffer tmp(src.rows, src.cols, neutral);
+  for(int y = 0; y < src.rows; y++)
+  {
+    for(int x = 0; x < src.cols; x++)
+    {
+      uint8_t value = neutral;
+      for(int a = std::max(0, x - before); a <= std::min(src.cols - 1, x + after); a++)
+        value = (op == MorphMin) ? std::min(value, src[y][a]) : std::max(value, src[y][a]);
+      tmp[y][x] = value;
+    }
+  }
+
+  dst = grayBuffer(src.rows, src.cols, neutral);
+  for(int y = 0; y < src.rows; y++)
+  {
+    for(int x = 0; x < src.cols; x++)
+    {
+      uint8_t value = neutral;
+      for(int b = std::max(0, y - before); b <= std::min(src.rows - 1, y + after); b++)
+        value = (op == MorphMin) ? std::min(value, tmp[b][x]) : std::max(value, tmp[b][x]);
+      dst[y][x] = value;
+    }
+  }
+}
+
+
+/*
+ * Test images: random content plus adversarial patterns (impulses on the borders, extreme constants,
+ * checkerboards, ramps). Widths are deliberately not multiples of the vector width.
+ */
+struct oracleCase
+{
+  std::string name;
+  grayBuffer image;
+};
+
+// Small deterministic generator, so every version sees exactly the same images
+inline uint32_t oracleRandom(uint32_t &state)
+{
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+inline std::vector<oracleCase> oracleImages(bool squareOnly)
+{
+  std::vector<oracleCase> cases;
+  const int sizes[][2] = { {64, 64}, {97, 131}, {131, 97}, {17, 3}, {1, 1}, {48, 48} };
+  uint32_t state = 2463534242u;
+
+  for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+  {
+    int rows = sizes[s][0];
+    int cols = sizes[s][1];
+    if(squareOnly && rows != cols)
+      continue;
+    std::string dims = std::to_string(rows) + "x" + std::to_string(cols);
+
+    oracleCase rnd = { "random_" + dims, grayBuffer(rows, cols) };
+    for(size_t i = 0; i < rnd.image.pixels.size(); i++)
+      rnd.image.pixels[i] = oracleRandom(state) & 0xFF;
+    cases.push_back(rnd);
+
+    oracleCase low = { "black_" + dims, grayBuffer(rows, cols, 0) };
+    oracleCase high = { "white_" + dims, grayBuffer(rows, cols, 255) };
+    cases.push_back(low);
+    cases.push_back(high);
+
+    // Single impulses on the corners and the center: catch shifted anchors and skipped borders
+    oracleCase bright = { "impulses_bright_" + dims, grayBuffer(rows, cols, 0) };
+    oracleCase dark = { "impulses_dark_" + dims, grayBuffer(rows, cols, 255) };
+    const int py[] = { 0, 0, rows - 1, rows - 1, rows / 2 };
+    const int px[] = { 0, cols - 1, 0, cols - 1, cols / 2 };
+    for(int k = 0; k < 5; k++)
+    {
+      bright.image[py[k]][px[k]] = 255;
+      dark.image[py[k]][px[k]] = 0;
+    }
+    cases.push_back(bright);
+    cases.push_back(dark);
+
+    oracleCase checker = { "checkerboard_" + dims, grayBuffer(rows, cols) };
+    oracleCase ramp = { "ramp_" + dims, grayBuffer(rows, cols) };
+    for(int y = 0; y < rows; y++)
+    {
+      for(int x = 0; x < cols; x++)
+      {
+        checker.image[y][x] = ((x + y) & 1) ? 255 : 0;
+        ramp.image[y][x] = (uint8_t)((3 * x + 7 * y) & 0xFF);
+      }
+    }
+    cases.push_back(checker);
+    cases.push_back(ramp);
+  }
+  return cases;
+}
+
+
+/*
+ * Comparison against the reference
+ */
+struct oracleDiff
+{
+  long mismatches;
+  int firstX;
+  int firstY;
+  grayBuffer map;                   // 255 where the outputs differ, 0 elsewhere
+};
+
+inline oracleDiff diffImages(const grayBuffer &expected, const grayBuffer &actual)
+{
+  oracleDiff diff;
+  diff.mismatches = 0;
+  diff.firstX = -1;
+  diff.firstY = -1;
+  diff.map = grayBuffer(expected.rows, expected.cols, 0);
+
+  if(actual.rows != expected.rows || actual.cols != expected.cols)
+  {
+    diff.mismatches = (long)expected.rows * expected.cols;
+    diff.map = grayBuffer(expected.rows, expected.cols, 255);
+    diff.firstX = 0;
+    diff.firstY = 0;
+    return diff;
+  }
+
+  for(int y = 0; y < expected.rows; y++)
+  {
+    for(int x = 0; x < expected.cols; x++)
+    {
+      if(expected[y][x] != actual[y][x])
+      {
+        if(diff.mismatches == 0)
+        {
+          diff.firstX = x;
+          diff.firstY = y;
+        }
+        diff.mismatches++;
+        diff.map[y][x] = 255;
+      }
+    }
+  }
+  return diff;
+}
+
+inline bool bitExact(const grayBuffer &src, const grayBuffer &result, int se_size, morphOperation op)
+{
+  grayBuffer expected;
+  referenceMorph(src, expected, se_size, op);
+  return diffImages(expected, result).mismatches == 0;
+}
+
+// Binary PGM (P5), readable by gnuplot, GIMP, ImageMagick...
+inline bool writePgm(const std::string &path, const grayBuffer &img)
+{
+  std::ofstream out(path.c_str(), std::ios::binary);
+  if(!out)
+    return false;
+  out << "P5\n" << img.cols << " " << img.rows << "\n255\n";
+  out.write(reinterpret_cast<const char *>(img.pixels.data()), img.pixels.size());
+  return out.good();
+}
+
+
+/*
+ * Verification mode: runs a backend on every test image and SE size, prints one line per failing case
+ * and writes its mismatch map. Returns the number of failing cases (0 means bit-exact everywhere).
+ */
+typedef std::function<void (const grayBuffer &, grayBuffer &, int, morphOperation)> morphBackend;
+
+inline int runOracle(const std::string &backend, morphBackend filter, const std::vector<int> &seSizes,
+                     bool squareOnly = false)
+{
+  std::vector<oracleCase> cases = oracleImages(squareOnly);
+  const morphOperation ops[] = { MorphMin, MorphMax };
+  int failures = 0;
+  int total = 0;
+
+  std::cout << "Verifying " << backend << " against the reference filters..." << std::endl;
+  for(size_t c = 0; c < cases.size(); c++)
+  {
+    for(size_t s = 0; s < seSizes.size(); s++)
+    {
+      for(int o = 0; o < 2; o++)
+      {
+        grayBuffer expected, actual;
+        referenceMorph(cases[c].image, expected, seSizes[s], ops[o]);
+        filter(cases[c].image, actual, seSizes[s], ops[o]);
+        oracleDiff diff = diffImages(expected, actual);
+        total++;
+        if(diff.mismatches == 0)
+          continue;
+
+        failures++;
+        std::string map = "mismatch_" + backend + "_" + morphName(ops[o]) + "_" + cases[c].name +
+                          "_se" + std::to_string(seSizes[s]) + ".pgm";
+        writePgm(map, diff.map);
+        std::cout << "  MISMATCH " << morphName(ops[o]) << " se=" << seSizes[s] << " " << cases[c].name
+                  << ": " << diff.mismatches << " pixels, first at (" << diff.firstX << ", "
+                  << diff.firstY << ") -> " << map << std::endl;
+      }
+    }
+  }
+  if(squareOnly)
+    std::cout << "  (non-square images skipped)" << std::endl;
+  std::cout << backend << ": " << (total - failures) << "/" << total << " cases bit-exact" << std::endl;
+  return failures;
+}
+
+#endif
@@ -0,0 +1,207 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Morphology Planner: picks the fastest min/max backend per problem and remembers it in a plan file
+*
+* The first time a problem signature (operation, SE size, image size, pixel type, cores) is seen on a
+* machine, every registered candidate is checked against the reference filter and timed on an image of
+* that size; the fastest bit-exact one is appended to the plan file. Later calls (and later runs) look the
+* winner up and dispatch directly, like FFTW's wisdom.
+*
+* Plan file, one line per tuned problem (the last line of a machine/problem pair wins):
+* machine,problem,backend,best_ms
+**************************************************************************************************************/
+
+#ifndef _MORPH_PLANNER_H_
+#define _MORPH_PLANNER_H_
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "benchHistory.h"
+#include "morphOracle.h"
+
+#define PLAN_FILE "../plans.csv"    // Shared by all versions (relative to each version folder)
+#define PLAN_REPETITIONS 3          // Timed calls per candidate (best of N, after one warm-up call)
+
+// What a plan depends on
+struct morphProblem
+{
+  morphOperation op;
+  int seSize;
+  int rows;
+  int cols;
+  unsigned int cores;
+
+  std::string signature() const
+  {
+    return std::string(morphName(op)) + "/se" + std::to_string(seSize) + "/" + std::to_string(rows) + "x" +
+           std::to_string(cols) + "/u8/" + std::to_string(cores) + "c";
+  }
+};
+
+
+class morphPlanner
+{
+public:
+  explicit morphPlanner(const std::string &planFile = PLAN_FILE)
+    : planFile_(planFile), cores_(std::thread::hardware_concurrency()),
+      machine_(machineFingerprint(readCpuModel(), cores_)), verbose_(true), persist_(true)
+  {
+    load();
+  }
+
+  // Candidates are tried in registration order (a tie keeps the first one)
+  void addCandidate(const std::string &name, morphBackend backend)
+  {
+    candidates_.push_back(std::make_pair(name, backend));
+  }
+
+  void setVerbose(bool verbose) { verbose_ = verbose; }
+
+  // Whether tuned plans are appended to the plan file (off: they are only kept for this run)
+  void setPersist(bool persist) { persist_ = persist; }
+
+  morphProblem problem(int rows, int cols, int se_size, morphOperation op) const
+  {
+    morphProblem p = { op, se_size, rows, cols, cores_ };
+    return p;
+  }
+
+  // Name of the backend planned for a problem, tuning it first if this machine has never seen it
+  std::string plan(const morphProblem &p)
+  {
+    std::string key = p.signature();
+    std::map<std::string, std::string>::const_iterator it = plans_.find(key);
+    if(it != plans_.end() && findCandidate(it->second) != NULL)
+      return it->second;
+    return tune(p);
+  }
+
+  // Runs the planned backend
+  void execute(const grayBuffer &src, grayBuffer &dst, int se_size, morphOperation op)
+  {
+    std::string name = plan(problem(src.rows, src.cols, se_size, op));
+    (*findCandidate(name))(src, dst, se_size, op);
+  }
+
+  // Drops what this machine has learnt, so the next plan() tunes again (the file keeps the old lines)
+  void forget()
+  {
+    plans_.clear();
+  }
+
+private:
+  const morphBackend *findCandidate(const std::string &name) const
+  {
+    for(size_t i = 0; i < candidates_.size(); i++)
+      if(candidates_[i].first == name)
+        return &candidates_[i].second;
+    return NULL;
+  }
+
+  void load()
+  {
+    std::ifstream in(planFile_.c_str());
+    std::string line;
+    while(std::getline(in, line))
+    {
+      if(line.empty() || line[0] == '#')
+        continue;
+      std::vector<std::string> f = splitCsv(line);
+      if(f.size() == 4 && f[0] == machine_)
+        plans_[f[1]] = f[2];
+    }
+  }
+
+  void save(const std::string &key, const std::string &backend, double seconds) const
+  {
+    bool exists = std::ifstream(planFile_.c_str()).good();
+    std::ofstream out(planFile_.c_str(), std::ios::app);
+    if(!out)
+    {
+      std::cerr << "Could not write the plan to " << planFile_ << std::endl;
+      return;
+    }
+    if(!exists)
+      out << "#machine,problem,backend,best_ms\n";
+    out << machine_ << "," << key << "," << backend << "," << formatMs(seconds) << "\n";
+  }
+
+  // Times every bit-exact candidate on a random image of the problem size and keeps the fastest
+  std::string tune(const morphProblem &p)
+  {
+    grayBuffer src(p.rows, p.cols), expected, actual;
+    uint32_t state = 88172645u;
+    for(size_t i = 0; i < src.pixels.size(); i++)
+      src.pixels[i] = oracleRandom(state) & 0xFF;
+    referenceMorph(src, expected, p.seSize, p.op);
+
+    std::string best;
+    double bestTime = 0.0;
+    for(size_t c = 0; c < candidates_.size(); c++)
+    {
+      const morphBackend &backend = candidates_[c].second;
+      backend(src, actual, p.seSize, p.op);                     // Warm-up and correctness check
+      if(diffImages(expected, actual).mismatches != 0)
+      {
+        if(verbose_)
+          std::cout << "  plan " << p.signature() << ": " << candidates_[c].first
+                    << " skipped (differs from the reference)" << std::endl;
+        continue;
+      }
+
+      double time = 0.0;
+      for(int k = 0; k < PLAN_REPETITIONS; k++)
+      {
+        auto start = std::chrono::high_resolution_clock::now();
+        backend(src, actual, p.seSize, p.op);
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> diff = end - start;
+        time = (k == 0) ? diff.count() : std::min(time, diff.count());
+      }
+      if(verbose_)
+        std::cout << "  plan " << p.signature() << ": " << candidates_[c].first << " " << formatMs(time)
+                  << " ms" << std::endl;
+      if(best.empty() || time < bestTime)
+      {
+        best = candidates_[c].first;
+        bestTime = time;
+      }
+    }
+
+    if(best.empty())
+    {
+      std::cerr << "No bit-exact backend for " << p.signature() << ", using the reference" << std::endl;
+      best = "reference";
+      if(findCandidate(best) == NULL)
+        candidates_.push_back(std::make_pair(best, morphBackend(referenceMorph)));
+    }
+    else if(persist_)
+      save(p.signature(), best, bestTime);
+
+    plans_[p.signature()] = best;
+    return best;
+  }
+
+  std::string planFile_;
+  unsigned int cores_;
+  std::string machine_;
+  bool verbose_;
+  bool persist_;
+  std::vector<std::pair<std::string, morphBackend> > candidates_;
+  std::map<std::string, std::string> plans_;     // Problem signature -> backend, for this machine
+};
+
+#endif
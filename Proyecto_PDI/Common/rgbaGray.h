@@ -0,0 +1,80 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* RGBA to Gray: row conversion with the same rounding as lti::channel8::castFrom(lti::image), that is
+* (R + G + B) / 3 truncated, so kernels can convert rows on the fly and still match the reference
+*
+* The pixels are interleaved 4-byte rgbaPixel values (blue, green, red, alpha in memory); the alpha byte is
+* ignored. With NEON, vld4q_u8 de-interleaves 16 pixels per load and the division by 3 is a doubling
+* multiply-high by 10923 (x * 21846 >> 16), exact for every sum 0..765.
+*
+* ltiDecodeGray is the grayInput decoder shared by the tools: the LTI-Lib only decodes to RGBA, so each
+* row is converted straight into the gray buffer.
+**************************************************************************************************************/
+
+#ifndef _RGBA_GRAY_H_
+#define _RGBA_GRAY_H_
+
+#include <string>
+
+#include <stdint.h>
+
+#include "ltiIOImage.h"
+#include "ltiImage.h"
+
+#include "morphOracle.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RGBA_GRAY_HAVE_NEON 1
+#endif
+
+// Row y of an lti::image (or any image of 4-byte pixels with contiguous rows) as bytes
+template<class Img>
+inline const uint8_t *rgbaRow(const Img &img, int y)
+{
+  return reinterpret_cast<const uint8_t *>(&img[y][0]);
+}
+
+inline void rgbaToGrayRow(const uint8_t *rgba, uint8_t *gray, int cols)
+{
+  int x = 0;
+#ifdef RGBA_GRAY_HAVE_NEON
+  const int16x8_t third = vdupq_n_s16(10923);
+  for(; x + 16 <= cols; x += 16)
+  {
+    uint8x16x4_t px = vld4q_u8(rgba + 4 * x);
+    uint16x8_t low = vaddw_u8(vaddl_u8(vget_low_u8(px.val[0]), vget_low_u8(px.val[1])),
+                              vget_low_u8(px.val[2]));
+    uint16x8_t high = vaddw_u8(vaddl_u8(vget_high_u8(px.val[0]), vget_high_u8(px.val[1])),
+                               vget_high_u8(px.val[2]));
+    low = vreinterpretq_u16_s16(vqdmulhq_s16(vreinterpretq_s16_u16(low), third));
+    high = vreinterpretq_u16_s16(vqdmulhq_s16(vreinterpretq_s16_u16(high), third));
+    vst1q_u8(gray + x, vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+  }
+#endif
+  for(; x < cols; x++)
+    gray[x] = (rgba[4 * x] + rgba[4 * x + 1] + rgba[4 * x + 2]) / 3;
+}
+
+// Decoder for grayInput: the LTI-Lib only decodes to RGBA, so each row goes straight to the gray buffer
+inline bool ltiDecodeGray(const std::string &path, grayBuffer &gray, std::string &error)
+{
+  lti::ioImage loader;
+  lti::image imgRgba;
+  if(!loader.load(path, imgRgba))
+  {
+    error = "Could not read " + path + ": " + loader.getStatusString();
+    return false;
+  }
+  gray = grayBuffer(imgRgba.rows(), imgRgba.columns());
+  for(int y = 0; y < gray.rows; y++)
+    rgbaToGrayRow(rgbaRow(imgRgba, y), gray[y], gray.cols);
+  return true;
+}
+
+#endif
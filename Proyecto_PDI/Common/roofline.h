@@ -0,0 +1,121 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Memory-Bandwidth Roofline: STREAM-style triad and achieved bandwidth of the image kernels
+*
+* Based on:
+* https://www.cs.virginia.edu/stream/ (STREAM benchmark, triad kernel)
+**************************************************************************************************************/
+
+#ifndef _ROOFLINE_H_
+#define _ROOFLINE_H_
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define STREAM_ARRAY_SIZE 8000000   // 3 arrays of 64 MB: well above the last level cache
+#define STREAM_REPETITIONS 5        // Best of N, as STREAM does
+
+// Achieved performance of one kernel against the machine roofline
+struct rooflinePoint
+{
+  double bytes;                     // Minimum traffic of the kernel (model below)
+  double gbps;                      // Achieved bandwidth
+  double pixelsPerCycle;            // 0 if the CPU frequency is unknown
+  double percent;                   // Achieved bandwidth / triad bandwidth
+};
+
+
+/*
+ * STREAM triad a[i] = b[i] + s * c[i] (single thread, like the kernels). Counts 24 bytes per element,
+ * as STREAM does. Measured once per process.
+ */
+inline double measureTriadBandwidth()
+{
+  std::vector<double> a(STREAM_ARRAY_SIZE, 0.0), b(STREAM_ARRAY_SIZE, 2.0), c(STREAM_ARRAY_SIZE, 1.0);
+  const double scalar = 3.0;
+  double best = 0.0;
+
+  for(int k = 0; k < STREAM_REPETITIONS; k++)
+  {
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < a.size(); i++)
+      a[i] = b[i] + scalar * c[i];
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diff = end - start;
+    best = (k == 0) ? diff.count() : std::min(best, diff.count());
+  }
+
+  if(a[a.size() / 2] != 5.0)       // Keeps the loop alive and checks the result
+    std::cerr << "STREAM triad validation failed" << std::endl;
+
+  return (3.0 * sizeof(double) * a.size()) / best / 1e9;
+}
+
+inline double triadBandwidth()
+{
+  static double bandwidth = measureTriadBandwidth();
+  return bandwidth;
+}
+
+// Nominal CPU frequency in Hz (cpufreq maximum, or "cpu MHz" from /proc/cpuinfo), 0 if unknown
+inline double cpuFrequency()
+{
+  std::ifstream cpufreq("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq");
+  double khz = 0.0;
+  if(cpufreq >> khz && khz > 0.0)
+    return khz * 1e3;
+
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while(std::getline(cpuinfo, line))
+  {
+    if(line.compare(0, 7, "cpu MHz") == 0 && line.find(':') != std::string::npos)
+      return std::stod(line.substr(line.find(':') + 1)) * 1e6;
+  }
+  return 0.0;
+}
+
+
+/*
+ * Traffic model: every pass over the image reads it once and writes it once (8-bit pixels). SE-sized
+ * neighbourhoods are assumed to be served by the caches, so this is the minimum DRAM traffic. Kernels that
+ * read or write other pixel formats give their own bytes per pixel instead.
+ */
+inline double passBytesPerPixel(int passes)
+{
+  return 2.0 * passes;
+}
+
+inline double kernelBytes(int width, int height, double bytesPerPixel)
+{
+  return bytesPerPixel * width * height;
+}
+
+inline rooflinePoint roofline(int width, int height, double bytesPerPixel, double seconds)
+{
+  rooflinePoint point;
+  double freq = cpuFrequency();
+  point.bytes = kernelBytes(width, height, bytesPerPixel);
+  point.gbps = (seconds > 0.0) ? point.bytes / seconds / 1e9 : 0.0;
+  point.pixelsPerCycle = (seconds > 0.0 && freq > 0.0) ? ((double)width * height) / (seconds * freq) : 0.0;
+  point.percent = 100.0 * point.gbps / triadBandwidth();
+  return point;
+}
+
+inline void printRoofline(const std::string &label, int width, int height, int passes, double seconds)
+{
+  rooflinePoint point = roofline(width, height, passBytesPerPixel(passes), seconds);
+  std::cout << label << " Bandwidth = " << point.gbps << " GB/s (" << point.percent << "% of the "
+            << triadBandwidth() << " GB/s roofline), " << point.pixelsPerCycle << " pixels/cycle" << std::endl;
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Out-of-Core Morphology: min/max filters over memory-mapped images, one band of rows at a time
+*
+* Each band is copied together with its SE halo (se_size/2 rows above, (se_size - 1)/2 below) into a small
+* buffer, filtered by any morphBackend and written to the mapped output. Pages already consumed are
+* released, so the resident memory is bounded by the band size and not by the image size. The result is
+* identical to filtering the whole image, because the kernels ignore pixels outside their buffer exactly
+* as they ignore pixels outside the image.
+**************************************************************************************************************/
+
+#ifndef _TILED_MORPH_H_
+#define _TILED_MORPH_H_
+
+#include <algorithm>
+#include <string>
+
+#include "mappedImage.h"
+#include "morphOracle.h"
+
+#define TILE_BAND_ROWS 256          // Default rows per band (plus the halo)
+
+struct tiledStats
+{
+  int bands;
+  size_t bandBytes;                 // Largest band buffer, halo included
+};
+
+inline tiledStats tiledMorph(const mappedImage &src, mappedImage &dst, int se_size, morphOperation op,
+                             morphBackend backend, int bandRows = TILE_BAND_ROWS)
+{
+  const int before = se_size / 2;
+  const int after = (se_size - 1) / 2;
+  const int rows = src.rows();
+  const int cols = src.cols();
+  tiledStats stats = { 0, 0 };
+
+  grayBuffer band, result;
+  for(int y0 = 0; y0 < rows; y0 += bandRows)
+  {
+    int y1 = std::min(rows, y0 + bandRows);
+    int top = std::max(0, y0 - before);
+    int bottom = std::min(rows, y1 + after);
+
+    band.rows = bottom - top;
+    band.cols = cols;
+    band.pixels.resize((size_t)band.rows * cols);
+    for(int y = top; y < bottom; y++)
+      std::copy(src.row(y), src.row(y) + cols, band[y - top]);
+
+    backend(band, result, se_size, op);
+    for(int y = y0; y < y1; y++)
+      std::copy(result[y - top], result[y - top] + cols, dst.row(y));
+
+    dst.flush(y0, y1);
+    dst.release(y0, y1);
+    src.release(top, std::max(top, y1 - before));     // The next halo starts at y1 - before
+
+    stats.bands++;
+    stats.bandBytes = std::max(stats.bandBytes, band.pixels.size());
+  }
+  return stats;
+}
+
+#endif
@@ -0,0 +1,288 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Compare: regression detection against a baseline revision of the benchmark history (../history.csv)
+*
+* For every (backend, operation, SE, image size, cache mode) measured in both revisions on the same machine,
+* a one-sided Welch t-test decides whether the candidate is significantly slower than the baseline. A
+* point also regresses when its output stops being bit-exact. The exit status is 1 if anything regressed,
+* so the command can gate merges. When both revisions were built with ALLOCSTATS=yes, more heap allocations
+* (or more allocated bytes beyond the threshold) are reported as regressions too.
+*
+* Based on:
+* Numerical Recipes in C, 2nd Ed., Section 6.4 (incomplete beta function) and 14.2 (Student's t-test)
+**************************************************************************************************************/
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "benchHistory.h"
+
+using namespace std;
+
+#define DEFAULT_ALPHA     0.05  // Significance level of the one-sided test
+#define DEFAULT_THRESHOLD 5.0   // Minimum slowdown (%) to report, filters out significant but tiny changes
+
+/*
+ * Help
+ */
+void usage()
+{
+  cout << "Usage: Compare <baseline_rev> [candidate_rev] [-f history.csv] [-m machine] [-a alpha] [-t pct]" << endl;
+  cout << "  baseline_rev  git revision (or prefix) used as reference." << endl;
+  cout << "  candidate_rev revision to check, by default the latest one in the history." << endl;
+  cout << "  -f history store, default " << HISTORY_FILE << "." << endl;
+  cout << "  -m machine fingerprint, default the current machine." << endl;
+  cout << "  -a significance level, default " << DEFAULT_ALPHA << "." << endl;
+  cout << "  -t minimum slowdown in percent, default " << DEFAULT_THRESHOLD << "." << endl;
+  cout << "  -h show this help." << endl;
+  cout << "Exit status: 0 no regression, 1 regression, 2 usage error or missing data." << endl;
+}
+
+
+/*
+ * Regularized incomplete beta function I_x(a, b)
+ */
+double betaContinuedFraction(double a, double b, double x)
+{
+  const int maxIt = 200;
+  const double eps = 3e-14, fpmin = 1e-300;
+  double qab = a + b, qap = a + 1.0, qam = a - 1.0;
+  double c = 1.0, d = 1.0 - qab * x / qap;
+  if(fabs(d) < fpmin)
+    d = fpmin;
+  d = 1.0 / d;
+  double h = d;
+  for(int m = 1; m <= maxIt; m++)
+  {
+    int m2 = 2 * m;
+    double aa = m * (b - m) * x / ((qam + m2) * (a + m2));
+    d = 1.0 + aa * d;
+    if(fabs(d) < fpmin)
+      d = fpmin;
+    c = 1.0 + aa / c;
+    if(fabs(c) < fpmin)
+      c = fpmin;
+    d = 1.0 / d;
+    h *= d * c;
+    aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2));
+    d = 1.0 + aa * d;
+    if(fabs(d) < fpmin)
+      d = fpmin;
+    c = 1.0 + aa / c;
+    if(fabs(c) < fpmin)
+      c = fpmin;
+    d = 1.0 / d;
+    double del = d * c;
+    h *= del;
+    if(fabs(del - 1.0) < eps)
+      break;
+  }
+  return h;
+}
+
+double incompleteBeta(double a, double b, double x)
+{
+  if(x <= 0.0)
+    return 0.0;
+  if(x >= 1.0)
+    return 1.0;
+  double bt = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log(1.0 - x));
+  if(x < (a + 1.0) / (a + b + 2.0))
+    return bt * betaContinuedFraction(a, b, x) / a;
+  return 1.0 - bt * betaContinuedFraction(b, a, 1.0 - x) / b;
+}
+
+/*
+ * One-sided Welch t-test: p-value of "candidate mean > baseline mean"
+ */
+double welchPValue(const vector<double> &base, const vector<double> &cand)
+{
+  double nb = base.size(), nc = cand.size();
+  if(nb < 2 || nc < 2)
+    return 1.0;                                   // Not enough samples to claim anything
+
+  double mb = sampleMean(base), mc = sampleMean(cand);
+  double vb = sampleVariance(base) * nb / (nb - 1.0); // Unbiased variances
+  double vc = sampleVariance(cand) * nc / (nc - 1.0);
+  double se2 = vb / nb + vc / nc;
+  if(se2 <= 0.0)
+    return (mc > mb) ? 0.0 : 1.0;                 // No noise at all: any difference is significant
+
+  double t = (mc - mb) / sqrt(se2);
+  double df = se2 * se2 / ((vb / nb) * (vb / nb) / (nb - 1.0) + (vc / nc) * (vc / nc) / (nc - 1.0));
+  double tail = 0.5 * incompleteBeta(0.5 * df, 0.5, df / (df + t * t));
+  return (t > 0.0) ? tail : 1.0 - tail;
+}
+
+
+// Key of one comparable timing point
+string pointKey(const benchRecord &r)
+{
+  return r.backend + " " + r.operation + " se=" + to_string(r.seSize) + " " + to_string(r.width) + "x" +
+         to_string(r.height) + " " + r.cacheMode;
+}
+
+bool matchesRevision(const string &revision, const string &prefix)
+{
+  return !prefix.empty() && revision.compare(0, prefix.size(), prefix) == 0;
+}
+
+struct pointSamples
+{
+  vector<double> samples;
+  bool bitExact;
+  allocReport allocs;               // Allocation counts are deterministic: the last run is kept
+};
+
+
+/*
+ * Main Function
+ */
+int main(int argc, char **argv)
+{
+  string historyPath = HISTORY_FILE;
+  string machine = collectMetadata().machine;
+  string baseline, candidate;
+  double alpha = DEFAULT_ALPHA;
+  double threshold = DEFAULT_THRESHOLD;
+
+  for(int i = 1; i < argc; i++)
+  {
+    string arg = argv[i];
+    if(arg == "-h")
+    {
+      usage();
+      return EXIT_SUCCESS;
+    }
+    else if((arg == "-f" || arg == "-m" || arg == "-a" || arg == "-t") && i + 1 < argc)
+    {
+      string value = argv[++i];
+      if(arg == "-f")
+        historyPath = value;
+      else if(arg == "-m")
+        machine = value;
+      else if(arg == "-a")
+        alpha = atof(value.c_str());
+      else
+        threshold = atof(value.c_str());
+    }
+    else if(baseline.empty())
+      baseline = arg;
+    else
+      candidate = arg;
+  }
+
+  if(baseline.empty())
+  {
+    usage();
+    return 2;
+  }
+
+  vector<historyEntry> history = loadHistory(historyPath);
+
+  // Latest revision measured on this machine is the default candidate
+  string latest;
+  string latestStamp;
+  for(size_t i = 0; i < history.size(); i++)
+  {
+    if(history[i].machine == machine && history[i].timestamp >= latestStamp)
+    {
+      latestStamp = history[i].timestamp;
+      latest = history[i].revision;
+    }
+  }
+  if(candidate.empty())
+    candidate = latest;
+
+  map<string, pointSamples> base, cand;
+  for(size_t i = 0; i < history.size(); i++)
+  {
+    const historyEntry &e = history[i];
+    if(e.machine != machine)
+      continue;
+    map<string, pointSamples> *target = NULL;
+    if(matchesRevision(e.revision, baseline))
+      target = &base;
+    else if(matchesRevision(e.revision, candidate))
+      target = &cand;
+    if(target == NULL)
+      continue;
+
+    string key = pointKey(e.record);
+    bool first = (target->find(key) == target->end());
+    pointSamples &point = (*target)[key];
+    point.samples.insert(point.samples.end(), e.record.samples.begin(), e.record.samples.end());
+    point.bitExact = first ? e.record.bitExact : (point.bitExact && e.record.bitExact);
+    if(e.record.allocs.valid)
+      point.allocs = e.record.allocs;
+  }
+
+  if(base.empty() || cand.empty())
+  {
+    cerr << "No results for " << (base.empty() ? baseline : candidate) << " on machine " << machine
+         << " in " << historyPath << endl;
+    return 2;
+  }
+
+  cout << "Baseline " << baseline << " vs candidate " << candidate << " (machine " << machine << ")" << endl;
+  cout << fixed << setprecision(3);
+
+  int regressions = 0;
+  int compared = 0;
+  for(map<string, pointSamples>::const_iterator it = cand.begin(); it != cand.end(); ++it)
+  {
+    map<string, pointSamples>::const_iterator ref = base.find(it->first);
+    if(ref == base.end())
+      continue;
+    compared++;
+
+    double mb = sampleMean(ref->second.samples) * 1000.0;
+    double mc = sampleMean(it->second.samples) * 1000.0;
+    double change = (mb > 0.0) ? 100.0 * (mc - mb) / mb : 0.0;
+    double p = welchPValue(ref->second.samples, it->second.samples);
+
+    const allocReport &ab = ref->second.allocs;
+    const allocReport &ac = it->second.allocs;
+    bool allocsMeasured = ab.valid && ac.valid;
+
+    string verdict = "ok";
+    if(ref->second.bitExact && !it->second.bitExact)
+      verdict = "REGRESSION (no longer bit-exact)";
+    else if(allocsMeasured && (ac.allocations > ab.allocations ||
+                               ac.bytes > ab.bytes * (1.0 + threshold / 100.0)))
+      verdict = "REGRESSION (more heap allocations)";
+    else if(p < alpha && change > threshold)
+      verdict = "REGRESSION";
+    else if(p < alpha && change > 0.0)
+      verdict = "slower (below threshold)";
+
+    if(verdict.compare(0, 10, "REGRESSION") == 0)
+      regressions++;
+
+    cout << "  " << it->first << ": " << mb << " ms -> " << mc << " ms (" << showpos << change << noshowpos
+         << "%, p=" << p << ")";
+    if(allocsMeasured)
+      cout << ", allocs " << ab.allocations << " -> " << ac.allocations << " (" << ab.bytes << " -> "
+           << ac.bytes << " bytes)";
+    cout << " " << verdict << endl;
+  }
+
+  if(compared == 0)
+  {
+    cerr << "The revisions have no timing point in common" << endl;
+    return 2;
+  }
+
+  cout << regressions << " regression(s) in " << compared << " point(s)" << endl;
+  return (regressions > 0) ? 1 : 0;
+}
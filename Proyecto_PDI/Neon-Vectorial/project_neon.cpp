@@ -69,6 +69,13 @@ typedef lti::viewer2D viewer_type;
 #include <arm_neon.h>
 #include <math.h>
 
+#include "allocStats.h"
+#include "benchResults.h"
+#include "benchHistory.h"
+#include "morphOracle.h"
+#include "alignedImage.h"
+#include "rgbaGray.h"
+
 using std::cout;
 using std::cerr;
 using std::endl;
@@ -77,15 +84,17 @@ using std::endl;
 #define NUM_POINTS  2      // Num of time samples
 #define NUM_TIME_IT 4       // Num of measurements before compute the mean time
 #define MIN_KERNEL_SIZE 5   // Min Kernel size
-#define NUM_ALGORITHMS 2    // 2 Algorithms: Min and Max Filter
+#define NUM_PASSES 2        // Passes over the image per filter (roofline), vertical (Dy) and horizontal (Dx)
+#define RGBA_BYTES_PER_PIXEL 7 // Fused RGBA path (roofline): RGBA read 4, Dy write and read 2, Dx write 1
 
 using namespace std;
 
 
 //Global Variables
-string filename = "data.dat";
-string titles = "se_size\tmin\tmax";
-vector< vector<double> > finalTimes(NUM_POINTS, vector<double>(2)); // Vector for timing results
+string filename = "data";                   // Results are written to data.csv and data.json
+string cacheMode = "cold";                  // "cold": caches dropped before each sample, "warm": no flush
+bool verifyMode = false;                    // Run the correctness oracle instead of the benchmark
+benchResults results("Neon-Vectorial", NUM_PASSES); // Timing results with the run metadata
 
 /*
  * Help 
@@ -93,30 +102,18 @@ vector< vector<double> > finalTimes(NUM_POINTS, vector<double>(2)); // Vector fo
 void usage() {
   cout << "Usage: matrixTransform [image] [-h]" << endl;
   cout << "  -h show this help." << endl;
+  cout << "  -w warm caches (do not run clearCache.sh before each sample)." << endl;
+  cout << "  -v verify the filters against the reference implementation and exit." << endl;
 }
 
 
-// Create a file with the results for GNU-Plot
+// Create the result files: CSV for GNU-Plot and JSON for further processing, and keep the run in the history
 void createData()
 {
-  string titles_wr = "echo \"" + titles + "\" > " + filename;
-  string times_wr = "echo \"";
-  system(titles_wr.c_str());
-  string tmp_wr = "";
-  string ksize = "";
-  string tmp_time = "";
-  for(int i = 1; i < NUM_POINTS; i++)
-  {
-    ksize = std::to_string(i * MIN_KERNEL_SIZE);
-    tmp_wr = ksize + "\t";
-    for(int j = 0; j < NUM_ALGORITHMS; j++)
-    {
-      tmp_time = std::to_string(finalTimes[i][j] * 1000.0);
-      (j == (NUM_ALGORITHMS - 1)) ? tmp_wr += tmp_time : tmp_wr += (tmp_time + "\t");
-    }
-    system((times_wr + tmp_wr + "\" >> " + filename).c_str());
-    tmp_wr = "";
-  }
+  if(!results.writeCsv(filename + ".csv") || !results.writeJson(filename + ".json"))
+    cerr << "Could not write the timing data to " << filename << ".csv/.json" << endl;
+  if(!appendHistory(HISTORY_FILE, results))
+    cerr << "Could not append the results to " << HISTORY_FILE << endl;
 }
 
 
@@ -135,6 +132,12 @@ void parseArgs(int argc, char*argv[],
           usage();
           exit(EXIT_SUCCESS);
           break;
+        case 'w':
+          cacheMode = "warm";
+          break;
+        case 'v':
+          verifyMode = true;
+          break;
         default:
           break;
       }
@@ -145,79 +148,188 @@ void parseArgs(int argc, char*argv[],
 }
 
 
-void minFilterSepDy(const lti::channel8 &src, lti::channel8 &dst, int se_size)
+/*
+ * The kernels work on views of an alignedImage (see alignedImage.h): rows are 64-byte aligned and surrounded
+ * by a halo filled with the neutral value (255 for min, 0 for max), so every loop runs whole aligned vectors
+ * with no border or tail cases. The halo must be at least se_size + 1 pixels. A view of a sub-region reads
+ * the real neighbours around it instead of the halo; its columns are written in whole vectors, so a view
+ * that does not reach the right edge of the image needs a multiple of 16 columns.
+ */
+#define ALIGNED(p) ((const uint8_t *)__builtin_assume_aligned((p), VECTOR_WIDTH))
+
+void minFilterSepDy(const imageView &src, const imageView &dst, int se_size)
 {
-  int width = src.columns();
-  int height = src.rows();
-  uint8_t wing = (se_size - 1) / 2;
-  for (int y = wing; y < height - wing - 1; y += 2)
+  int width = src.cols;
+  int height = src.rows;
+  int before = se_size / 2;
+  int after = (se_size - 1) / 2;
+  for (int y = 0; y < height; y += 2)
   {
     for (int x = 0; x < width; x += 16)
     { 
-      uint8x16_t val = vld1q_u8(&src[y - wing + 1][x]);
-      for (int k = -wing + 2; k <= wing; k++)
-        val = vminq_u8(val, vld1q_u8(&src[y + k][x]));
+      uint8x16_t val = vdupq_n_u8(255);            // Rows shared by y and y + 1 (none if se_size == 1)
+      for (int k = -before + 1; k <= after; k++)
+        val = vminq_u8(val, vld1q_u8(ALIGNED(&src[y + k][x])));
 
-      vst1q_u8(&dst[y][x], vminq_u8(val, vld1q_u8(&src[y - wing][x])));
-      vst1q_u8(&dst[y + 1][x], vminq_u8(val, vld1q_u8(&src[y + wing + 1][x])));
+      vst1q_u8(&dst[y][x], vminq_u8(val, vld1q_u8(ALIGNED(&src[y - before][x]))));
+      if (y + 1 < height)                          // Odd heights: not past the end of a sub-region
+        vst1q_u8(&dst[y + 1][x], vminq_u8(val, vld1q_u8(ALIGNED(&src[y + after + 1][x]))));
     }
   }
 }
 
-void minFilterSepDx(const lti::channel8 &src, lti::channel8 &dst, int se_size)
+void minFilterSepDx(const imageView &src, const imageView &dst, int se_size)
 {
-  int width = src.columns();
-  int height = src.rows();
-  uint8_t wing = (se_size - 1) / 2;
+  int width = src.cols;
+  int height = src.rows;
+  int before = se_size / 2;
+  for (int y = 0; y < height; y++)
+  {
+    for (int x = 0; x < width; x += 16)
+    {
+      uint8x16_t val = vld1q_u8(&src[y][x - before]);
+      for (int j = x - before + 1; j < x - before + se_size; j++)
+        val = vminq_u8(val, vld1q_u8(&src[y][j]));
+      vst1q_u8(&dst[y][x], val);
+    }
+  }
+}
+
+
+void maxFilterSepDy(const imageView &src, const imageView &dst, int se_size)
+{
+  int width = src.cols;
+  int height = src.rows;
+  int before = se_size / 2;
+  int after = (se_size - 1) / 2;
+  for (int y = 0; y < height; y += 2)
+  {
+    for (int x = 0; x < width; x += 16)
+    {
+      uint8x16_t val = vdupq_n_u8(0);              // Rows shared by y and y + 1 (none if se_size == 1)
+      for (int k = -before + 1; k <= after; k++)
+        val = vmaxq_u8(val, vld1q_u8(ALIGNED(&src[y + k][x])));
+
+      vst1q_u8(&dst[y][x], vmaxq_u8(val, vld1q_u8(ALIGNED(&src[y - before][x]))));
+      if (y + 1 < height)                          // Odd heights: not past the end of a sub-region
+        vst1q_u8(&dst[y + 1][x], vmaxq_u8(val, vld1q_u8(ALIGNED(&src[y + after + 1][x]))));
+    }
+  }
+}
+
+void maxFilterSepDx(const imageView &src, const imageView &dst, int se_size)
+{
+  int width = src.cols;
+  int height = src.rows;
+  int before = se_size / 2;
   for (int y = 0; y < height; y++)
   {
-    for (int x = wing; x < width; x += 16)
-	 {
-	   uint8x16_t val = vld1q_u8(&src[y][x - wing]);
-	   for (int j = x - wing + 1; j <= x + wing; j++)
-	     val = vminq_u8(val, vld1q_u8(&src[y][j]));
-	   vst1q_u8(&dst[y][x], val);
-	 }
+    for (int x = 0; x < width; x += 16)
+    {
+      uint8x16_t val = vld1q_u8(&src[y][x - before]);
+      for (int j = x - before + 1; j < x - before + se_size; j++)
+        val = vmaxq_u8(val, vld1q_u8(&src[y][j]));
+      vst1q_u8(&dst[y][x], val);
+    }
   }
 }
 
 
-void maxFilterSepDy(const lti::channel8 &src, lti::channel8 &dst, int se_size)
+/*
+ * Fused entry points for the RGBA input: the first (vertical) pass converts every RGBA row to gray once,
+ * into a ring of se_size gray rows that stays in L1, and combines the ring rows of each window. The gray
+ * image is never written to memory nor read back. The ring is allocated by the caller (se_size rows, no
+ * halo) with its padding set to the neutral value; dst needs the usual halo for the horizontal pass.
+ */
+void minFilterSepDyRgba(const lti::image &src, alignedImage &ring, const imageView &dst, int se_size)
 {
   int width = src.columns();
   int height = src.rows();
-  uint8_t wing = (se_size - 1) / 2;
-  for (int y = wing; y < height - wing - 1; y += 2)
+  int before = se_size / 2;
+  int after = (se_size - 1) / 2;
+  for (int r = 0; r < std::min(after, height); r++)
+    rgbaToGrayRow(rgbaRow(src, r), ring[r % se_size], width);
+  for (int y = 0; y < height; y++)
   {
+    if (y + after < height)                       // Overwrites row y - before - 1, no longer needed
+      rgbaToGrayRow(rgbaRow(src, y + after), ring[(y + after) % se_size], width);
+    int b0 = std::max(0, y - before);
+    int b1 = std::min(height - 1, y + after);
     for (int x = 0; x < width; x += 16)
     {
-      uint8x16_t val = vld1q_u8(&src[y - wing + 1][x]);
-      for (int k = -wing + 2; k <= wing; k++)
-        val = vmaxq_u8(val, vld1q_u8(&src[y + k][x]));
-
-      vst1q_u8(&dst[y][x], vmaxq_u8(val, vld1q_u8(&src[y - wing][x])));
-      vst1q_u8(&dst[y + 1][x], vmaxq_u8(val, vld1q_u8(&src[y + wing + 1][x])));
+      uint8x16_t val = vld1q_u8(ALIGNED(&ring[b0 % se_size][x]));
+      for (int b = b0 + 1; b <= b1; b++)
+        val = vminq_u8(val, vld1q_u8(ALIGNED(&ring[b % se_size][x])));
+      vst1q_u8(&dst[y][x], val);
     }
   }
 }
 
-void maxFilterSepDx(const lti::channel8 &src, lti::channel8 &dst, int se_size)
+void maxFilterSepDyRgba(const lti::image &src, alignedImage &ring, const imageView &dst, int se_size)
 {
   int width = src.columns();
   int height = src.rows();
-  uint8_t wing = (se_size - 1) / 2;
+  int before = se_size / 2;
+  int after = (se_size - 1) / 2;
+  for (int r = 0; r < std::min(after, height); r++)
+    rgbaToGrayRow(rgbaRow(src, r), ring[r % se_size], width);
   for (int y = 0; y < height; y++)
   {
-    for (int x = wing; x < width; x += 16)
-	 {
-	   uint8x16_t val = vld1q_u8(&src[y][x - wing]);
-	   for (int j = x - wing + 1; j <= x + wing; j++)
-	     val = vmaxq_u8(val, vld1q_u8(&src[y][j]));
-	   vst1q_u8(&dst[y][x], val);
-	 }
+    if (y + after < height)
+      rgbaToGrayRow(rgbaRow(src, y + after), ring[(y + after) % se_size], width);
+    int b0 = std::max(0, y - before);
+    int b1 = std::min(height - 1, y + after);
+    for (int x = 0; x < width; x += 16)
+    {
+      uint8x16_t val = vld1q_u8(ALIGNED(&ring[b0 % se_size][x]));
+      for (int b = b0 + 1; b <= b1; b++)
+        val = vmaxq_u8(val, vld1q_u8(ALIGNED(&ring[b % se_size][x])));
+      vst1q_u8(&dst[y][x], val);
+    }
   }
 }
 
+
+// Backend adapter for the verification mode (see morphOracle.h)
+void neonBackend(const grayBuffer &src, grayBuffer &dst, int se_size, morphOperation op)
+{
+  alignedImage in(src.rows, src.cols, se_size + 1), tmp(src.rows, src.cols, se_size + 1);
+  alignedImage out(src.rows, src.cols, se_size + 1);
+  uint8_t neutral = (op == MorphMin) ? 255 : 0;
+  for(int y = 0; y < src.rows; y++)
+    std::copy(src[y], src[y] + src.cols, in[y]);
+  in.fillHalo(neutral);
+  tmp.fillHalo(neutral);
+  if(op == MorphMin)
+  {
+    minFilterSepDy(in.view(), tmp.view(), se_size);
+    minFilterSepDx(tmp.view(), out.view(), se_size);
+  }
+  else
+  {
+    maxFilterSepDy(in.view(), tmp.view(), se_size);
+    maxFilterSepDx(tmp.view(), out.view(), se_size);
+  }
+  dst = grayBuffer(src.rows, src.cols);
+  for(int y = 0; y < src.rows; y++)
+    std::copy(out[y], out[y] + src.cols, dst[y]);
+}
+
+
+/*
+ * SE sizes for the verification mode: the benchmark sizes plus the degenerate 1x1 and 3x3 cases
+ */
+vector<int> verifySizes()
+{
+  vector<int> sizes;
+  sizes.push_back(1);
+  sizes.push_back(3);
+  for(int i = 1; i < NUM_POINTS; i++)
+    sizes.push_back(i * MIN_KERNEL_SIZE);
+  return sizes;
+}
+
+
 double getVariance(vector<double> samples, double avg)
 {
 	double result = 0.0;
@@ -226,6 +338,64 @@ double getVariance(vector<double> samples, double avg)
 	return result;
 }
 
+/*
+ * Times the fused RGBA path (conversion inside the vertical pass, then the horizontal pass) for one SE size
+ * and records it as "min_rgba"/"max_rgba", next to the gray input rows. separateTime is castFrom plus the
+ * gray filter, the per-frame cost the fused path replaces.
+ */
+void benchFused(const lti::image &imgRgba, const grayBuffer &grayBuf, alignedImage &ring, alignedImage &dy,
+                alignedImage &dx, lti::channel8 &outImg, int se_size, morphOperation op,
+                const std::string &imgFile, double separateTime)
+{
+  int width = imgRgba.columns();
+  int height = imgRgba.rows();
+  uint8_t neutral = (op == MorphMin) ? 255 : 0;
+  string label = (op == MorphMin) ? "Min Filter RGBA" : "Max Filter RGBA";
+  ring.allocate(se_size, width, 0);
+  ring.fillHalo(neutral);
+  dy.fillHalo(neutral);
+
+  double avg = 0;
+  vector<double> samples(NUM_TIME_IT);
+  allocReport allocs;
+  for(int j = 0; j < NUM_TIME_IT; j++)
+  {
+    if(cacheMode == "cold")
+      system("./clearCache.sh");
+    allocScope alloc;
+    auto start = std::chrono::high_resolution_clock::now();
+    if(op == MorphMin)
+    {
+      minFilterSepDyRgba(imgRgba, ring, dy.view(), se_size);
+      minFilterSepDx(dy.view(), dx.view(), se_size);
+    }
+    else
+    {
+      maxFilterSepDyRgba(imgRgba, ring, dy.view(), se_size);
+      maxFilterSepDx(dy.view(), dx.view(), se_size);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    allocs = alloc.stop();
+    std::chrono::duration<double> diff = end - start;
+    samples[j] = diff.count();
+    avg += (1.0 / NUM_TIME_IT) * diff.count();
+  }
+
+  grayBuffer resultBuf;
+  dx.copyTo(outImg);
+  bufferFromImage(outImg, resultBuf);
+  bool exact = bitExact(grayBuf, resultBuf, se_size, op);
+  results.add(string(morphName(op)) + "_rgba", imgFile, width, height, se_size, cacheMode, exact, samples,
+              allocs, RGBA_BYTES_PER_PIXEL);
+  cout << label << " Variance = " << getVariance(samples, avg) << endl;
+  cout << label << ": " << avg * 1000 << " ms fused, " << separateTime * 1000
+       << " ms with castFrom as a separate pass" << endl;
+  printAllocs(label, allocs);
+  if(!exact)
+    cout << "WARNING: " << label << " output differs from the reference (run with -v for details)" << endl;
+  cout << endl;
+}
+
 /*
  * Main method
  */
@@ -235,6 +405,9 @@ int main(int argc, char* argv[])
   std::string imgFile;
   parseArgs(argc,argv,imgFile);
 
+  if(verifyMode)
+    return (runOracle("Neon-Vectorial", neonBackend, verifySizes()) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+
   lti::ioImage loader; // used to load an image file
 
   lti::image imgRgba;
@@ -255,6 +428,22 @@ int main(int argc, char* argv[])
   gray.resize(height, width, 0);
   gray.castFrom(imgRgba);
 
+  grayBuffer grayBuf, resultBuf;  // Input and output for the bit-exactness check
+  bufferFromImage(gray, grayBuf);
+
+  // Cost of the separate conversion pass, for the comparison with the fused RGBA path
+  double castTime = 0;
+  for(int j = 0; j < NUM_TIME_IT; j++)
+  {
+    if(cacheMode == "cold")
+      system("./clearCache.sh");
+    auto startC = std::chrono::high_resolution_clock::now();
+    gray.castFrom(imgRgba);
+    auto endC = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diffC = endC - startC;
+    castTime += (1.0 / NUM_TIME_IT) * diffC.count();
+  }
+
   #ifdef DISPLAY
   bool theEnd = false;
   lti::viewer2D view("Original Image");
@@ -270,33 +459,56 @@ int main(int argc, char* argv[])
   theEnd = false;
   #endif
   
+  // Aligned images with a halo for the largest SE, allocated once and reused by every SE size and sample
+  int halo = (NUM_POINTS - 1) * MIN_KERNEL_SIZE + 1;
+  alignedImage grayImg, minImgDy, minImgDx, maxImgDy, maxImgDx, grayRing;
+  grayImg.copyFrom(gray, halo);
+  minImgDy.allocate(height, width, halo);
+  minImgDx.allocate(height, width, halo);
+  maxImgDy.allocate(height, width, halo);
+  maxImgDx.allocate(height, width, halo);
+  lti::channel8 minImg, maxImg;
+  minImg.resize(height, width, 0);
+  maxImg.resize(height, width, 0);
+
   for(int i = 1; i < NUM_POINTS; i++)
   {
-    // Apply algorithm;
-    lti::channel8 minImgDy, minImgDx;
-    minImgDy.resize(height, width, 0);
-    minImgDx.resize(height, width, 0);
+    // Apply algorithm; the halos take the neutral value of the operation (not timed, like the allocation)
+    grayImg.fillHalo(255);
+    minImgDy.fillHalo(255);
     std::chrono::duration<double> diffA;
     double avgA = 0;
     vector<double> samplesA(NUM_TIME_IT);
+    allocReport allocsA;
     for(int j = 0; j < NUM_TIME_IT; j++)
     {
-	  system("./clearCache.sh");
+	  if(cacheMode == "cold")
+	    system("./clearCache.sh");
+      allocScope allocA;
       auto startA = std::chrono::high_resolution_clock::now();
-      minFilterSepDy(gray, minImgDy, i * MIN_KERNEL_SIZE);
-      minFilterSepDx(minImgDy, minImgDx, i * MIN_KERNEL_SIZE);
+      minFilterSepDy(grayImg.view(), minImgDy.view(), i * MIN_KERNEL_SIZE);
+      minFilterSepDx(minImgDy.view(), minImgDx.view(), i * MIN_KERNEL_SIZE);
       auto endA = std::chrono::high_resolution_clock::now();
+      allocsA = allocA.stop();
       diffA = endA - startA;
       samplesA[j] = diffA.count();
       avgA += (1.0 / NUM_TIME_IT) * diffA.count();
     }
-    finalTimes[i][0] = avgA;
-    cout << "Min Filter Variance = " << getVariance(samplesA, avgA) << endl << endl;
+    minImgDx.copyTo(minImg);
+    bufferFromImage(minImg, resultBuf);
+    bool exactA = bitExact(grayBuf, resultBuf, i * MIN_KERNEL_SIZE, MorphMin);
+    results.add("min", imgFile, width, height, i * MIN_KERNEL_SIZE, cacheMode, exactA, samplesA, allocsA);
+    cout << "Min Filter Variance = " << getVariance(samplesA, avgA) << endl;
+    printRoofline("Min Filter", width, height, NUM_PASSES, avgA);
+    printAllocs("Min Filter", allocsA);
+    if(!exactA)
+      cout << "WARNING: Min Filter output differs from the reference (run with -v for details)" << endl;
+    cout << endl;
 
     #ifdef DISPLAY
     lti::viewer2D view2("Min Image");
     lti::viewer2D::interaction action2;
-    view2.show(minImgDx);
+    view2.show(minImg);
     lti::ipoint pos2;
     do {
           view2.waitInteraction(action2,pos2); // wait for something to happen
@@ -307,30 +519,41 @@ int main(int argc, char* argv[])
     theEnd = false;
     #endif
 
-    lti::channel8 maxImgDy, maxImgDx;
-    maxImgDy.resize(height, width, 0);
-    maxImgDx.resize(height, width, 0);
+    grayImg.fillHalo(0);
+    maxImgDy.fillHalo(0);
     std::chrono::duration<double> diffB;
     double avgB = 0;
     vector<double> samplesB(NUM_TIME_IT);
+    allocReport allocsB;
     for(int j = 0; j < NUM_TIME_IT; j++)
     {
-	  system("./clearCache.sh");
+	  if(cacheMode == "cold")
+	    system("./clearCache.sh");
+      allocScope allocB;
       auto startB = std::chrono::high_resolution_clock::now();
-      maxFilterSepDy(gray, maxImgDy, i * MIN_KERNEL_SIZE);
-      maxFilterSepDx(maxImgDy, maxImgDx, i * MIN_KERNEL_SIZE);
+      maxFilterSepDy(grayImg.view(), maxImgDy.view(), i * MIN_KERNEL_SIZE);
+      maxFilterSepDx(maxImgDy.view(), maxImgDx.view(), i * MIN_KERNEL_SIZE);
       auto endB = std::chrono::high_resolution_clock::now();
+      allocsB = allocB.stop();
       diffB = endB - startB;
       samplesB[j] = diffB.count();
       avgB += (1.0 / NUM_TIME_IT) * diffB.count();
     }
-    finalTimes[i][1] = avgB;
-    cout << "Max Filter Variance = " << getVariance(samplesB, avgB) << endl << endl;
+    maxImgDx.copyTo(maxImg);
+    bufferFromImage(maxImg, resultBuf);
+    bool exactB = bitExact(grayBuf, resultBuf, i * MIN_KERNEL_SIZE, MorphMax);
+    results.add("max", imgFile, width, height, i * MIN_KERNEL_SIZE, cacheMode, exactB, samplesB, allocsB);
+    cout << "Max Filter Variance = " << getVariance(samplesB, avgB) << endl;
+    printRoofline("Max Filter", width, height, NUM_PASSES, avgB);
+    printAllocs("Max Filter", allocsB);
+    if(!exactB)
+      cout << "WARNING: Max Filter output differs from the reference (run with -v for details)" << endl;
+    cout << endl;
 
     #ifdef DISPLAY
     lti::viewer2D view3("Max Image");
     lti::viewer2D::interaction action3;
-    view3.show(maxImgDx);
+    view3.show(maxImg);
     lti::ipoint pos3;
     do {
           view3.waitInteraction(action3,pos3); // wait for something to happen
@@ -338,8 +561,14 @@ int main(int argc, char* argv[])
             theEnd = true; // we are ready here!
           } 
         } while(!theEnd);
-    #endif
     theEnd = false;
+    #endif
+
+    // Same filters straight from the RGBA image, with the conversion fused into the vertical pass
+    benchFused(imgRgba, grayBuf, grayRing, minImgDy, minImgDx, minImg, i * MIN_KERNEL_SIZE, MorphMin, imgFile,
+               castTime + avgA);
+    benchFused(imgRgba, grayBuf, grayRing, maxImgDy, maxImgDx, maxImg, i * MIN_KERNEL_SIZE, MorphMax, imgFile,
+               castTime + avgB);
   }
 
   //Generating Timing Results
@@ -18,41 +18,66 @@
 #include <vector>
 #include <chrono>
 
+#include "allocStats.h"
+#include "benchResults.h"
+#include "benchHistory.h"
+#include "morphOracle.h"
+
 //#define DISPLAY 1          // Show images if un-commented
 #define NUM_POINTS  2      // Num of time samples
 #define NUM_TIME_IT 4       // Num of measurements before compute the mean time
 #define MIN_KERNEL_SIZE 5   // Min Kernel size
-#define NUM_ALGORITHMS 2    // 2 Algorithms: Min and Max Filter
+#define NUM_PASSES 2        // Passes over the image per filter (roofline), separable rectangular SE
 
 using namespace std;
 using namespace cv;
 
 //Global Variables
-string filename = "data.dat";
-string titles = "se_size\tmin\tmax";
-vector< vector<double> > finalTimes(NUM_POINTS, vector<double>(2)); // Vector for timing results
+string filename = "data";                   // Results are written to data.csv and data.json
+string cacheMode = "cold";                  // "cold": caches dropped before each sample, "warm": no flush
+bool verifyMode = false;                    // Run the correctness oracle instead of the benchmark
+benchResults results("OpenCV", NUM_PASSES); // Timing results with the run metadata
 
-// Create a file with the results for GNU-Plot
+// Create the result files: CSV for GNU-Plot and JSON for further processing, and keep the run in the history
 void createData()
 {
-  string titles_wr = "echo \"" + titles + "\" > " + filename;
-  string times_wr = "echo \"";
-  system(titles_wr.c_str());
-  string tmp_wr = "";
-  string ksize = "";
-  string tmp_time = "";
+  if(!results.writeCsv(filename + ".csv") || !results.writeJson(filename + ".json"))
+    cerr << "Could not write the timing data to " << filename << ".csv/.json" << endl;
+  if(!appendHistory(HISTORY_FILE, results))
+    cerr << "Could not append the results to " << HISTORY_FILE << endl;
+}
+
+
+// Copy of a (continuous) CV_8U matrix for the bit-exactness check
+void bufferFromMat(const Mat &img, grayBuffer &buf)
+{
+  buf = grayBuffer(img.rows, img.cols);
+  for(int y = 0; y < img.rows; y++)
+    std::copy(img.ptr<uchar>(y), img.ptr<uchar>(y) + img.cols, buf[y]);
+}
+
+// Backend adapter for the verification mode (see morphOracle.h), same SE as the benchmark
+void opencvBackend(const grayBuffer &src, grayBuffer &dst, int se_size, morphOperation op)
+{
+  Mat in(src.rows, src.cols, CV_8U, const_cast<uint8_t *>(src.pixels.data()));
+  Mat out;
+  cv::Mat se_kernel = getStructuringElement(cv::MORPH_RECT, Size(se_size, se_size), Point(0, 0));
+  if(op == MorphMin)
+    cv::erode(in, out, se_kernel);
+  else
+    cv::dilate(in, out, se_kernel);
+  bufferFromMat(out, dst);
+}
+
+// SE sizes for the verification mode: the benchmark sizes plus the degenerate 1x1 and 3x3 cases
+vector<int> verifySizes()
+{
+  vector<int> sizes;
+  sizes.push_back(1);
+  sizes.push_back(3);
   for(int i = 1; i < NUM_POINTS; i++)
-  {
-    ksize = std::to_string(i * MIN_KERNEL_SIZE);
-    tmp_wr = ksize + "\t";
-    for(int j = 0; j < NUM_ALGORITHMS; j++)
-    {
-      tmp_time = std::to_string(finalTimes[i][j] * 1000.0);
-      (j == (NUM_ALGORITHMS - 1)) ? tmp_wr += tmp_time : tmp_wr += (tmp_time + "\t");
-    }
-    system((times_wr + tmp_wr + "\" >> " + filename).c_str());
-    tmp_wr = "";
-  }
+    sizes.push_back(i * MIN_KERNEL_SIZE);
+  return sizes;
 }
 
 
@@ -71,10 +96,25 @@ double getVariance(vector<double> samples, double avg)
 int main(int argc, char** argv) 
 {
   cout << "Starting the Program..." << endl;
+
+  string imgFile;
+  for(int i = 1; i < argc; i++)                                             // Options: -w warm caches, -v verify
+  {
+    string arg = argv[i];
+    if(arg == "-w")
+      cacheMode = "warm";
+    else if(arg == "-v")
+      verifyMode = true;
+    else
+      imgFile = arg;
+  }
+
+  if(verifyMode)
+    return (runOracle("OpenCV", opencvBackend, verifySizes()) == 0) ? 0 : -1;
   
   Mat src;
   Mat display_srcimage;
-  src = imread(argv[1], CV_LOAD_IMAGE_GRAYSCALE);                           // Read the file
+  src = imread(imgFile, CV_LOAD_IMAGE_GRAYSCALE);                           // Read the file
 
   if(! src.data )                                                           // Check for invalid input
   {
@@ -82,6 +122,12 @@ int main(int argc, char** argv)
       return -1;
   }
 
+  int width = src.cols;                                                     // Image size
+  int height = src.rows;
+
+  grayBuffer grayBuf, resultBuf;                                            // For the bit-exactness check
+  bufferFromMat(src, grayBuf);
+
   #ifdef DISPLAY
   //Display input image resized:
   namedWindow( "Display image", WINDOW_AUTOSIZE );                          // Create a window for display.
@@ -98,18 +144,29 @@ int main(int argc, char** argv)
     std::chrono::duration<double> diffA;
     double avgA = 0;
     vector<double> samplesA(NUM_TIME_IT);
+    allocReport allocsA;
     for(int j = 0; j < NUM_TIME_IT; j++)
     {
-	  system("./clearCache.sh");
+	  if(cacheMode == "cold")
+	    system("./clearCache.sh");
+      allocScope allocA;
       auto startA = std::chrono::high_resolution_clock::now();
       cv::erode(src, minImage, se_kernel);
       auto endA = std::chrono::high_resolution_clock::now();
+      allocsA = allocA.stop();
       diffA = endA - startA;
       samplesA[j] = diffA.count();
       avgA += (1.0 / NUM_TIME_IT) * diffA.count();
     }
-    finalTimes[i][0] = avgA;
-    cout << "Min Filter Variance = " << getVariance(samplesA, avgA) << endl << endl;
+    bufferFromMat(minImage, resultBuf);
+    bool exactA = bitExact(grayBuf, resultBuf, i * MIN_KERNEL_SIZE, MorphMin);
+    results.add("min", imgFile, width, height, i * MIN_KERNEL_SIZE, cacheMode, exactA, samplesA, allocsA);
+    cout << "Min Filter Variance = " << getVariance(samplesA, avgA) << endl;
+    printRoofline("Min Filter", width, height, NUM_PASSES, avgA);
+    printAllocs("Min Filter", allocsA);
+    if(!exactA)
+      cout << "WARNING: Min Filter output differs from the reference (run with -v for details)" << endl;
+    cout << endl;
 
     #ifdef DISPLAY
     namedWindow( "Display image", WINDOW_AUTOSIZE );                          // Create a window for display.
@@ -121,18 +178,29 @@ int main(int argc, char** argv)
     std::chrono::duration<double> diffB;
     double avgB = 0;
     vector<double> samplesB(NUM_TIME_IT);
+    allocReport allocsB;
     for(int j = 0; j < NUM_TIME_IT; j++)
     {
-	  system("./clearCache.sh");
+	  if(cacheMode == "cold")
+	    system("./clearCache.sh");
+      allocScope allocB;
       auto startB = std::chrono::high_resolution_clock::now();
       cv::dilate(src, maxImage, se_kernel);
       auto endB = std::chrono::high_resolution_clock::now();
+      allocsB = allocB.stop();
       diffB = endB - startB;
       samplesB[j] = diffB.count();
       avgB += (1.0 / NUM_TIME_IT) * diffB.count();
     }
-    finalTimes[i][1] = avgB;
-    cout << "Max Filter Variance = " << getVariance(samplesB, avgB) << endl << endl;
+    bufferFromMat(maxImage, resultBuf);
+    bool exactB = bitExact(grayBuf, resultBuf, i * MIN_KERNEL_SIZE, MorphMax);
+    results.add("max", imgFile, width, height, i * MIN_KERNEL_SIZE, cacheMode, exactB, samplesB, allocsB);
+    cout << "Max Filter Variance = " << getVariance(samplesB, avgB) << endl;
+    printRoofline("Max Filter", width, height, NUM_PASSES, avgB);
+    printAllocs("Max Filter", allocsB);
+    if(!exactB)
+      cout << "WARNING: Max Filter output differs from the reference (run with -v for details)" << endl;
+    cout << endl;
 
     #ifdef DISPLAY
     namedWindow( "Display image", WINDOW_AUTOSIZE );                          // Create a window for display.
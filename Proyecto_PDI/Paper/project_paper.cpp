@@ -66,6 +66,11 @@ typedef lti::viewer2D viewer_type;
 #include <queue>
 #include <deque>
 
+#include "allocStats.h"
+#include "benchResults.h"
+#include "benchHistory.h"
+#include "morphOracle.h"
+
 using std::cout;
 using std::cerr;
 using std::endl;
@@ -74,15 +79,16 @@ using std::endl;
 #define NUM_POINTS  2      // Num of time samples
 #define NUM_TIME_IT 4       // Num of measurements before compute the mean time
 #define MIN_KERNEL_SIZE 5   // Min Kernel size
-#define NUM_ALGORITHMS 2    // 2 Algorithms: Min and Max Filter
+#define NUM_PASSES 1        // Passes over the image per filter (roofline), streaming with one FIFO per column
 
 using namespace std;
 
 
 //Global Variables
-string filename = "data.dat";
-string titles = "se_size\tmin\tmax";
-vector< vector<double> > finalTimes(NUM_POINTS, vector<double>(2)); // Vector for timing results
+string filename = "data";                   // Results are written to data.csv and data.json
+string cacheMode = "cold";                  // "cold": caches dropped before each sample, "warm": no flush
+bool verifyMode = false;                    // Run the correctness oracle instead of the benchmark
+benchResults results("Paper", NUM_PASSES);  // Timing results with the run metadata
 
 /*
  * Help 
@@ -90,30 +96,18 @@ vector< vector<double> > finalTimes(NUM_POINTS, vector<double>(2)); // Vector fo
 void usage() {
   cout << "Usage: matrixTransform [image] [-h]" << endl;
   cout << "  -h show this help." << endl;
+  cout << "  -w warm caches (do not run clearCache.sh before each sample)." << endl;
+  cout << "  -v verify the filters against the reference implementation and exit." << endl;
 }
 
 
-// Create a file with the results for GNU-Plot
+// Create the result files: CSV for GNU-Plot and JSON for further processing, and keep the run in the history
 void createData()
 {
-  string titles_wr = "echo \"" + titles + "\" > " + filename;
-  string times_wr = "echo \"";
-  system(titles_wr.c_str());
-  string tmp_wr = "";
-  string ksize = "";
-  string tmp_time = "";
-  for(int i = 1; i < NUM_POINTS; i++)
-  {
-    ksize = std::to_string(i * MIN_KERNEL_SIZE);
-    tmp_wr = ksize + "\t";
-    for(int j = 0; j < NUM_ALGORITHMS; j++)
-    {
-      tmp_time = std::to_string(finalTimes[i][j] * 1000.0);
-      (j == (NUM_ALGORITHMS - 1)) ? tmp_wr += tmp_time : tmp_wr += (tmp_time + "\t");
-    }
-    system((times_wr + tmp_wr + "\" >> " + filename).c_str());
-    tmp_wr = "";
-  }
+  if(!results.writeCsv(filename + ".csv") || !results.writeJson(filename + ".json"))
+    cerr << "Could not write the timing data to " << filename << ".csv/.json" << endl;
+  if(!appendHistory(HISTORY_FILE, results))
+    cerr << "Could not append the results to " << HISTORY_FILE << endl;
 }
 
 
@@ -132,6 +126,12 @@ void parseArgs(int argc, char*argv[],
           usage();
           exit(EXIT_SUCCESS);
           break;
+        case 'w':
+          cacheMode = "warm";
+          break;
+        case 'v':
+          verifyMode = true;
+          break;
         default:
           break;
       }
@@ -230,17 +230,21 @@ pair <uint8_t, bool> OneD_Erosion(int rp, int wp, uint8_t F, int SE1, int SE2, i
 /*
 * Dilation (MaxFilter)
 */
-lti::channel8 TwoD_Dilation(const lti::channel8 &in_stream, int M, int N, int SE1, int SE2, int SE3, int SE4)
+void TwoD_Dilation(const lti::channel8 &in_stream, lti::channel8 &out_stream, int M, int N, int SE1, int SE2, int SE3, int SE4)
 {
-  lti::channel8 out_stream;
-  out_stream.resize(M, N, 0);
+  if(out_stream.rows() != M || out_stream.columns() != N)  //Filled in place: no temporary image, no copy
+    out_stream.resize(M, N, 0);
+  else
+    out_stream.fill((uint8_t)0);                //Line 0 and column 0 are never written: no stale values
 
   pair <uint8_t, bool> oneDResponsex;
   pair <uint8_t, bool> oneDResponsey;
 
   const uint8_t PAD = 0;                        //Set the padding constant
-  vector< deque< pair<uint8_t, int> > > vfifo;  //Array of N empty FIFOs for the vertical dilation part
+  static vector< deque< pair<uint8_t, int> > > vfifo;  //N FIFOs for the vertical part, kept between calls
   vfifo.resize(N);
+  for(int i = 0; i < N; i++)
+    vfifo[i].clear();
 
   int line_rd = 1;                              //Read line counter
   int line_wr = 1;                              //Written line counter
@@ -251,7 +255,7 @@ lti::channel8 TwoD_Dilation(const lti::channel8 &in_stream, int M, int N, int SE
   uint8_t F;
   uint8_t dFx, dFy;
 
-  deque< pair<uint8_t, int> > hfifo;
+  static deque< pair<uint8_t, int> > hfifo;    //Kept between calls, cleared per line
 
   //Iterate over all image lines
   while(line_wr < M)
@@ -296,24 +300,27 @@ lti::channel8 TwoD_Dilation(const lti::channel8 &in_stream, int M, int N, int SE
     if(oneDResponsey.second)
       line_wr = line_wr + 1;
   }
-  return out_stream;
 }
 
 
 /*
 * Erosion (MinFilter)
 */
-lti::channel8 TwoD_Erosion(const lti::channel8 &in_stream, int M, int N, int SE1, int SE2, int SE3, int SE4)
+void TwoD_Erosion(const lti::channel8 &in_stream, lti::channel8 &out_stream, int M, int N, int SE1, int SE2, int SE3, int SE4)
 {
-  lti::channel8 out_stream;
-  out_stream.resize(M, N, 0);
+  if(out_stream.rows() != M || out_stream.columns() != N)  //Filled in place: no temporary image, no copy
+    out_stream.resize(M, N, 0);
+  else
+    out_stream.fill((uint8_t)0);                //Line 0 and column 0 are never written: no stale values
 
   pair <uint8_t, bool> oneDResponsex;
   pair <uint8_t, bool> oneDResponsey;
 
   const uint8_t PAD = 0;                        //Set the padding constant
-  vector< deque< pair<uint8_t, int> > > vfifo;  //Array of N empty FIFOs for the vertical dilation part
+  static vector< deque< pair<uint8_t, int> > > vfifo;  //N FIFOs for the vertical part, kept between calls
   vfifo.resize(N);
+  for(int i = 0; i < N; i++)
+    vfifo[i].clear();
 
   int line_rd = 1;                              //Read line counter
   int line_wr = 1;                              //Written line counter
@@ -324,7 +331,7 @@ lti::channel8 TwoD_Erosion(const lti::channel8 &in_stream, int M, int N, int SE1
   uint8_t F;
   uint8_t dFx, dFy;
 
-  deque< pair<uint8_t, int> > hfifo;
+  static deque< pair<uint8_t, int> > hfifo;    //Kept between calls, cleared per line
 
   //Iterate over all image lines
   while(line_wr < M)
@@ -369,7 +376,6 @@ lti::channel8 TwoD_Erosion(const lti::channel8 &in_stream, int M, int N, int SE1
     if(oneDResponsey.second)
       line_wr = line_wr + 1;
   }
-  return out_stream;
 }
 
 
@@ -379,7 +385,7 @@ void maxFilterDokladal(const lti::channel8 &src, lti::channel8 &dst, const int s
   int height = src.rows();
   int se_mid = (se_size - 1) / 2;
 
-  dst = TwoD_Dilation(src, height, width, se_mid, se_mid, se_mid, se_mid);
+  TwoD_Dilation(src, dst, height, width, se_mid, se_mid, se_mid, se_mid);
 }
 
 void minFilterDokladal(const lti::channel8 &src, lti::channel8 &dst, const int se_size)
@@ -388,7 +394,34 @@ void minFilterDokladal(const lti::channel8 &src, lti::channel8 &dst, const int s
   int height = src.rows();
   int se_mid = (se_size - 1) / 2;
 
-  dst = TwoD_Erosion(src, height, width, se_mid, se_mid, se_mid, se_mid);
+  TwoD_Erosion(src, dst, height, width, se_mid, se_mid, se_mid, se_mid);
+}
+
+
+// Backend adapter for the verification mode (see morphOracle.h)
+void paperBackend(const grayBuffer &src, grayBuffer &dst, int se_size, morphOperation op)
+{
+  lti::channel8 in, out;
+  imageFromBuffer(src, in);
+  if(op == MorphMin)
+    minFilterDokladal(in, out, se_size);
+  else
+    maxFilterDokladal(in, out, se_size);
+  bufferFromImage(out, dst);
+}
+
+
+/*
+ * SE sizes for the verification mode: the benchmark sizes plus the degenerate 1x1 and 3x3 cases
+ */
+vector<int> verifySizes()
+{
+  vector<int> sizes;
+  sizes.push_back(1);
+  sizes.push_back(3);
+  for(int i = 1; i < NUM_POINTS; i++)
+    sizes.push_back(i * MIN_KERNEL_SIZE);
+  return sizes;
 }
 
 
@@ -409,6 +442,10 @@ int main(int argc, char* argv[])
   std::string imgFile;
   parseArgs(argc,argv,imgFile);
 
+  // TwoD_Dilation/TwoD_Erosion index the image as [column][line], so only square images are verified
+  if(verifyMode)
+    return (runOracle("Paper", paperBackend, verifySizes(), true) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+
   lti::ioImage loader; // used to load an image file
 
   lti::image imgRgba;
@@ -429,6 +466,9 @@ int main(int argc, char* argv[])
   gray.resize(height, width, 0);
   gray.castFrom(imgRgba);
 
+  grayBuffer grayBuf, resultBuf;  // Input and output for the bit-exactness check
+  bufferFromImage(gray, grayBuf);
+
   #ifdef DISPLAY
   bool theEnd = false;
   lti::viewer2D view("Original Image");
@@ -453,18 +493,29 @@ int main(int argc, char* argv[])
     std::chrono::duration<double> diffA;
     double avgA = 0;
     vector<double> samplesA(NUM_TIME_IT);
+    allocReport allocsA;
     for(int j = 0; j < NUM_TIME_IT; j++)
     {
-	    system("./clearCache.sh");
+	    if(cacheMode == "cold")
+	      system("./clearCache.sh");
+      allocScope allocA;
       auto startA = std::chrono::high_resolution_clock::now();
       minFilterDokladal(gray, minImg, i * MIN_KERNEL_SIZE);
       auto endA = std::chrono::high_resolution_clock::now();
+      allocsA = allocA.stop();
       diffA = endA - startA;
       samplesA[j] = diffA.count();
       avgA += (1.0 / NUM_TIME_IT) * diffA.count();
     }
-    finalTimes[i][0] = avgA;
-    cout << "Min Filter Variance = " << getVariance(samplesA, avgA) << endl << endl;
+    bufferFromImage(minImg, resultBuf);
+    bool exactA = bitExact(grayBuf, resultBuf, i * MIN_KERNEL_SIZE, MorphMin);
+    results.add("min", imgFile, width, height, i * MIN_KERNEL_SIZE, cacheMode, exactA, samplesA, allocsA);
+    cout << "Min Filter Variance = " << getVariance(samplesA, avgA) << endl;
+    printRoofline("Min Filter", width, height, NUM_PASSES, avgA);
+    printAllocs("Min Filter", allocsA);
+    if(!exactA)
+      cout << "WARNING: Min Filter output differs from the reference (run with -v for details)" << endl;
+    cout << endl;
 
     #ifdef DISPLAY
     lti::viewer2D view2("Min Image");
@@ -485,18 +536,29 @@ int main(int argc, char* argv[])
     std::chrono::duration<double> diffB;
     double avgB = 0;
     vector<double> samplesB(NUM_TIME_IT);
+    allocReport allocsB;
     for(int j = 0; j < NUM_TIME_IT; j++)
     {
-	    system("./clearCache.sh");
+	    if(cacheMode == "cold")
+	      system("./clearCache.sh");
+      allocScope allocB;
       auto startB = std::chrono::high_resolution_clock::now();
       maxFilterDokladal(gray, maxImg, i * MIN_KERNEL_SIZE);
       auto endB = std::chrono::high_resolution_clock::now();
+      allocsB = allocB.stop();
       diffB = endB - startB;
       samplesB[j] = diffB.count();
       avgB += (1.0 / NUM_TIME_IT) * diffB.count();
     }
-    finalTimes[i][1] = avgB;
-    cout << "Max Filter Variance = " << getVariance(samplesB, avgB) << endl << endl;
+    bufferFromImage(maxImg, resultBuf);
+    bool exactB = bitExact(grayBuf, resultBuf, i * MIN_KERNEL_SIZE, MorphMax);
+    results.add("max", imgFile, width, height, i * MIN_KERNEL_SIZE, cacheMode, exactB, samplesB, allocsB);
+    cout << "Max Filter Variance = " << getVariance(samplesB, avgB) << endl;
+    printRoofline("Max Filter", width, height, NUM_PASSES, avgB);
+    printAllocs("Max Filter", allocsB);
+    if(!exactB)
+      cout << "WARNING: Max Filter output differs from the reference (run with -v for details)" << endl;
+    cout << endl;
 
     #ifdef DISPLAY
     lti::viewer2D view3("Max Image");
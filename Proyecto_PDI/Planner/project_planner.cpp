@@ -0,0 +1,435 @@
+/*
+ * Copyright (C) 2007 by Pablo Alvarado
+ * 
+ * This file is part of the LTI-Computer Vision Library 2 (LTI-Lib-2)
+ *
+ * The LTI-Lib-2 is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the authors nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** 
+ * \file   surfLocalDescriptor.cpp
+ *         Contains an example of use for the class lti::surfLocalDescriptor
+ * \author Pablo Alvarado
+ * \date   04.11.2007
+ * revisions ..: $Id: matrixTransform.cpp,v 1.5 2011-08-29 14:17:33 alvarado Exp $
+ */
+
+// LTI-Lib Headers
+#include "ltiObject.h"
+#include "ltiIOImage.h"
+#include "ltiMath.h"
+#include "ltiPassiveWait.h"
+
+#include "ltiMinimumFilter.h"
+#include "ltiMaximumFilter.h"
+#include "ltiChannel8.h"
+
+#include "ltiLispStreamHandler.h"
+
+#include "ltiViewer2D.h" // The normal viewer
+typedef lti::viewer2D viewer_type;
+
+// Standard Headers
+#include <cstdlib>
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <fstream>
+
+#include "allocStats.h"
+#include "benchResults.h"
+#include "benchHistory.h"
+#include "morphOracle.h"
+#include "morphContext.h"
+#include "morphKernels.h"
+#include "morphPlanner.h"
+#include "grayIngest.h"
+#include "rgbaGray.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+//#define DISPLAY 1          // Show images if un-commented
+#define NUM_POINTS  2      // Num of time samples
+#define NUM_TIME_IT 4       // Num of measurements before compute the mean time
+#define MIN_KERNEL_SIZE 5   // Min Kernel size
+#define NUM_PASSES 2        // Passes over the image per filter (roofline), the candidates are separable
+
+using namespace std;
+
+
+//Global Variables
+string filename = "data";                   // Results are written to data.csv and data.json
+string cacheMode = "cold";                  // "cold": caches dropped before each sample, "warm": no flush
+bool verifyMode = false;                    // Run the correctness oracle instead of the benchmark
+bool replan = false;                        // Tune again even if the plan file has the problem
+bool batchMode = false;                     // Filter every image given instead of benchmarking one
+vector<string> inputFiles;                  // Every image named in the command line
+benchResults results("Planner", NUM_PASSES); // Timing results with the run metadata
+morphPlanner planner;                       // Fastest backend per problem, persisted in PLAN_FILE
+morphContext context;                       // Scratch buffers of the streaming candidate, kept across calls
+
+// Create the result files: CSV for GNU-Plot and JSON for further processing, and keep the run in the history
+void createData()
+{
+  if(!results.writeCsv(filename + ".csv") || !results.writeJson(filename + ".json"))
+    cerr << "Could not write the timing data to " << filename << ".csv/.json" << endl;
+  if(!appendHistory(HISTORY_FILE, results))
+    cerr << "Could not append the results to " << HISTORY_FILE << endl;
+}
+
+
+/*
+ * Help 
+ */
+void usage() {
+  cout << "Usage: matrixTransform [image] [-h]" << endl;
+  cout << "  -h show this help." << endl;
+  cout << "  -w warm caches (do not run clearCache.sh before each sample)." << endl;
+  cout << "  -v verify the filters against the reference implementation and exit." << endl;
+  cout << "  -r re-tune the backends even if the plan file already has the problem." << endl;
+  cout << "  -b batch: filter every image given (binary PGM files are mapped), decoding the next one" << endl;
+  cout << "     in the background while the current one is filtered." << endl;
+}
+
+/*
+ * Parse the line command arguments
+ */
+void parseArgs(int argc, char*argv[], 
+               std::string& filename) {
+  
+  filename.clear();
+  // check each argument of the command line
+  for (int i=1; i<argc; i++) {
+    if (*argv[i] == '-') {
+      switch (argv[i][1]) {
+        case 'h':
+          usage();
+          exit(EXIT_SUCCESS);
+          break;
+        case 'w':
+          cacheMode = "warm";
+          break;
+        case 'v':
+          verifyMode = true;
+          break;
+        case 'r':
+          replan = true;
+          break;
+        case 'b':
+          batchMode = true;
+          break;
+        default:
+          break;
+      }
+    } else {
+      filename = argv[i];
+      inputFiles.push_back(argv[i]);
+    }
+  }
+}
+
+
+
+// The library call as one more planner candidate
+void ltiBackend(const grayBuffer &src, grayBuffer &dst, int se_size, morphOperation op)
+{
+  lti::channel8 in, out;
+  imageFromBuffer(src, in);
+  if(op == MorphMin)
+  {
+    lti::minimumFilter<lti::ubyte> minFilter(se_size);
+    minFilter.setSquareMaskWindow(se_size);
+    minFilter.apply(in, out);
+  }
+  else
+  {
+    lti::maximumFilter<lti::ubyte> maxFilter(se_size);
+    maxFilter.setSquareMaskWindow(se_size);
+    maxFilter.apply(in, out);
+  }
+  bufferFromImage(out, dst);
+}
+
+
+// Streaming candidate: reuses its buffers (and the output image), no allocation once warmed up
+void contextBackend(const grayBuffer &src, grayBuffer &dst, int se_size, morphOperation op)
+{
+  context.apply(src, dst, se_size, op);
+}
+
+// Candidates: the kernels of morphKernels.h, the streaming context and the LTI-Lib filters
+void addCandidates()
+{
+  vector< pair<string, morphBackend> > kernels = morphKernels();
+  for(size_t k = 0; k < kernels.size(); k++)
+    planner.addCandidate(kernels[k].first, kernels[k].second);
+  planner.addCandidate("context", contextBackend);
+  planner.addCandidate("ltilib", ltiBackend);
+}
+
+// Backend adapter for the verification mode (see morphOracle.h)
+void plannerBackend(const grayBuffer &src, grayBuffer &dst, int se_size, morphOperation op)
+{
+  planner.execute(src, dst, se_size, op);
+}
+
+
+/*
+ * SE sizes for the verification mode: the benchmark sizes plus the degenerate 1x1 and 3x3 cases
+ */
+vector<int> verifySizes()
+{
+  vector<int> sizes;
+  sizes.push_back(1);
+  sizes.push_back(3);
+  for(int i = 1; i < NUM_POINTS; i++)
+    sizes.push_back(i * MIN_KERNEL_SIZE);
+  return sizes;
+}
+
+
+double getVariance(vector<double> samples, double avg)
+{
+	double result = 0.0;
+	for(int i = 0; i < NUM_TIME_IT; i++)
+		result += pow((avg - samples[i]), 2) / NUM_TIME_IT;
+	return result;
+}
+
+
+/*
+ * Batch mode: min and max of every image with the smallest benchmark SE. The streaming context reads the
+ * rows in place (mapped PGM or decoded buffer) while the prefetcher loads the next image; "wait" is the
+ * time the filters stood idle because the next image was not ready yet.
+ */
+int runBatch()
+{
+  grayPrefetcher prefetcher(inputFiles, ltiDecodeGray);
+  grayBuffer minBuf, maxBuf;
+  int done = 0, failed = 0;
+  double waitTime = 0, filterTime = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+  for(;;)
+  {
+    auto startWait = std::chrono::high_resolution_clock::now();
+    std::shared_ptr<grayInput> input = prefetcher.next();
+    auto endWait = std::chrono::high_resolution_clock::now();
+    if(!input)
+      break;
+    waitTime += std::chrono::duration<double>(endWait - startWait).count();
+    if(!input->error().empty())
+    {
+      cerr << input->error() << endl;
+      failed++;
+      continue;
+    }
+
+    auto startFilter = std::chrono::high_resolution_clock::now();
+    context.apply(input->view(), minBuf, MIN_KERNEL_SIZE, MorphMin);
+    context.apply(input->view(), maxBuf, MIN_KERNEL_SIZE, MorphMax);
+    auto endFilter = std::chrono::high_resolution_clock::now();
+    double diff = std::chrono::duration<double>(endFilter - startFilter).count();
+    filterTime += diff;
+    cout << input->path() << ": " << input->rows() << "x" << input->cols()
+         << (input->mapped() ? " mapped" : " decoded") << ", min+max " << diff * 1000 << " ms" << endl;
+    done++;
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  double total = std::chrono::duration<double>(end - start).count();
+
+  cout << done << " images (" << failed << " failed) in " << total << " s, " << done / total
+       << " images/s; filtering " << filterTime << " s, waiting for input " << waitTime << " s" << endl;
+  return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*
+ * Main method
+ */
+int main(int argc, char* argv[]) 
+{
+
+  std::string imgFile;
+  parseArgs(argc,argv,imgFile);
+
+  addCandidates();
+  if(replan)
+    planner.forget();
+
+  if(verifyMode)
+  {
+    planner.setVerbose(false);
+    planner.setPersist(false);      // The oracle sizes are not worth remembering in the plan file
+    return (runOracle("Planner", plannerBackend, verifySizes()) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  if(batchMode)
+    return runBatch();
+
+  // Gray input: binary PGM files are mapped, other formats decoded straight to gray
+  grayInput input;
+  if (!input.open(imgFile, ltiDecodeGray)) {
+    std::cerr << input.error() << std::endl;
+    usage();
+    exit(EXIT_FAILURE);
+  }
+
+  // Image size
+  int width = input.cols();
+  int height = input.rows();
+
+  grayBuffer grayBuf;             // The planned kernels work on plain gray buffers
+  input.copyTo(grayBuf);
+
+  #ifdef DISPLAY
+  bool theEnd = false;
+  lti::viewer2D view("Original Image");
+  lti::viewer2D::interaction action;
+  lti::channel8 gray;
+  imageFromBuffer(grayBuf, gray);
+  view.show(gray);
+  lti::ipoint pos;
+
+  do {
+        view.waitInteraction(action,pos); // wait for something to happen
+        if (action == lti::viewer2D::Closed) { // window closed?
+          theEnd = true; // we are ready here!
+        } 
+      } while(!theEnd);
+  theEnd = false;
+  #endif
+  
+  for(int i = 1; i < NUM_POINTS; i++)
+  {
+    // Plan before timing: the first time a problem is seen the candidates are benchmarked here
+    int se = i * MIN_KERNEL_SIZE;
+    cout << "Min Filter Backend = " << planner.plan(planner.problem(height, width, se, MorphMin)) << endl;
+    cout << "Max Filter Backend = " << planner.plan(planner.problem(height, width, se, MorphMax)) << endl;
+
+    // Apply algorithm;
+    grayBuffer minBuf;
+    std::chrono::duration<double> diffA;
+    double avgA = 0;
+    vector<double> samplesA(NUM_TIME_IT);
+    allocReport allocsA;
+    for(int j = 0; j < NUM_TIME_IT; j++)
+    {
+	  if(cacheMode == "cold")
+	    system("./clearCache.sh");
+      allocScope allocA;
+      auto startA = std::chrono::high_resolution_clock::now();
+      planner.execute(grayBuf, minBuf, se, MorphMin);
+      auto endA = std::chrono::high_resolution_clock::now();
+      allocsA = allocA.stop();
+      diffA = endA - startA;
+      samplesA[j] = diffA.count();
+      avgA += (1.0 / NUM_TIME_IT) * diffA.count();
+    }
+    bool exactA = bitExact(grayBuf, minBuf, se, MorphMin);
+    results.add("min", imgFile, width, height, se, cacheMode, exactA, samplesA, allocsA);
+    cout << "Min Filter Variance = " << getVariance(samplesA, avgA) << endl;
+    printRoofline("Min Filter", width, height, NUM_PASSES, avgA);
+    printAllocs("Min Filter", allocsA);
+    if(!exactA)
+      cout << "WARNING: Min Filter output differs from the reference (run with -v for details)" << endl;
+    cout << endl;
+
+    #ifdef DISPLAY
+    lti::viewer2D view2("Min Image");
+    lti::viewer2D::interaction action2;
+    lti::channel8 minImg;
+    imageFromBuffer(minBuf, minImg);
+    view2.show(minImg);
+    lti::ipoint pos2;
+    do {
+          view2.waitInteraction(action2,pos2); // wait for something to happen
+          if (action2 == lti::viewer2D::Closed) { // window closed?
+            theEnd = true; // we are ready here!
+          } 
+        } while(!theEnd);
+    theEnd = false;
+    #endif
+
+    grayBuffer maxBuf;
+    std::chrono::duration<double> diffB;
+    double avgB = 0;
+    vector<double> samplesB(NUM_TIME_IT);
+    allocReport allocsB;
+    for(int j = 0; j < NUM_TIME_IT; j++)
+    {
+	  if(cacheMode == "cold")
+	    system("./clearCache.sh");
+      allocScope allocB;
+      auto startB = std::chrono::high_resolution_clock::now();
+      planner.execute(grayBuf, maxBuf, se, MorphMax);
+      auto endB = std::chrono::high_resolution_clock::now();
+      allocsB = allocB.stop();
+      diffB = endB - startB;
+      samplesB[j] = diffB.count();
+      avgB += (1.0 / NUM_TIME_IT) * diffB.count();
+    }
+    bool exactB = bitExact(grayBuf, maxBuf, se, MorphMax);
+    results.add("max", imgFile, width, height, se, cacheMode, exactB, samplesB, allocsB);
+    cout << "Max Filter Variance = " << getVariance(samplesB, avgB) << endl;
+    printRoofline("Max Filter", width, height, NUM_PASSES, avgB);
+    printAllocs("Max Filter", allocsB);
+    if(!exactB)
+      cout << "WARNING: Max Filter output differs from the reference (run with -v for details)" << endl;
+    cout << endl;
+
+    #ifdef DISPLAY
+    lti::viewer2D view3("Max Image");
+    lti::viewer2D::interaction action3;
+    lti::channel8 maxImg;
+    imageFromBuffer(maxBuf, maxImg);
+    view3.show(maxImg);
+    lti::ipoint pos3;
+    do {
+          view3.waitInteraction(action3,pos3); // wait for something to happen
+          if (action3 == lti::viewer2D::Closed) { // window closed?
+            theEnd = true; // we are ready here!
+          } 
+        } while(!theEnd);
+    theEnd = false;
+    #endif
+  }
+
+  //Generating Timing Results
+  cout << "Generating the Timing Data..." << endl;;
+  createData();
+  
+  return EXIT_SUCCESS;
+}
@@ -63,6 +63,11 @@ typedef lti::viewer2D viewer_type;
 #include <chrono>
 #include <fstream>
 
+#include "allocStats.h"
+#include "benchResults.h"
+#include "benchHistory.h"
+#include "morphOracle.h"
+
 using std::cout;
 using std::cerr;
 using std::endl;
@@ -71,15 +76,16 @@ using std::endl;
 #define NUM_POINTS  2       // Num of time samples 2 -> 5x5
 #define NUM_TIME_IT 4       // Num of measurements before compute the mean time
 #define MIN_KERNEL_SIZE 5   // Min Kernel size
-#define NUM_ALGORITHMS 2    // 2 Algorithms: Min and Max Filter
+#define NUM_PASSES 1        // Passes over the image per filter (roofline), the SE neighbourhood is read from cache
 
 using namespace std;
 
 
 //Global Variables
-string filename = "data.dat";
-string titles = "se_size\tmin\tmax";
-vector< vector<double> > finalTimes(NUM_POINTS, vector<double>(2)); // Vector for timing results
+string filename = "data";                   // Results are written to data.csv and data.json
+string cacheMode = "cold";                  // "cold": caches dropped before each sample, "warm": no flush
+bool verifyMode = false;                    // Run the correctness oracle instead of the benchmark
+benchResults results("Serial", NUM_PASSES); // Timing results with the run metadata
 
 /*
  * Help 
@@ -87,30 +93,18 @@ vector< vector<double> > finalTimes(NUM_POINTS, vector<double>(2)); // Vector fo
 void usage() {
   cout << "Usage: matrixTransform [image] [-h]" << endl;
   cout << "  -h show this help." << endl;
+  cout << "  -w warm caches (do not run clearCache.sh before each sample)." << endl;
+  cout << "  -v verify the filters against the reference implementation and exit." << endl;
 }
 
 
-// Create a file with the results for GNU-Plot
+// Create the result files: CSV for GNU-Plot and JSON for further processing, and keep the run in the history
 void createData()
 {
-  string titles_wr = "echo \"" + titles + "\" > " + filename;
-  string times_wr = "echo \"";
-  system(titles_wr.c_str());
-  string tmp_wr = "";
-  string ksize = "";
-  string tmp_time = "";
-  for(int i = 1; i < NUM_POINTS; i++)
-  {
-    ksize = std::to_string(i * MIN_KERNEL_SIZE);
-    tmp_wr = ksize + "\t";
-    for(int j = 0; j < NUM_ALGORITHMS; j++)
-    {
-      tmp_time = std::to_string(finalTimes[i][j] * 1000.0);
-      (j == (NUM_ALGORITHMS - 1)) ? tmp_wr += tmp_time : tmp_wr += (tmp_time + "\t");
-    }
-    system((times_wr + tmp_wr + "\" >> " + filename).c_str());
-    tmp_wr = "";
-  }
+  if(!results.writeCsv(filename + ".csv") || !results.writeJson(filename + ".json"))
+    cerr << "Could not write the timing data to " << filename << ".csv/.json" << endl;
+  if(!appendHistory(HISTORY_FILE, results))
+    cerr << "Could not append the results to " << HISTORY_FILE << endl;
 }
 
 
@@ -129,6 +123,12 @@ void parseArgs(int argc, char*argv[],
           usage();
           exit(EXIT_SUCCESS);
           break;
+        case 'w':
+          cacheMode = "warm";
+          break;
+        case 'v':
+          verifyMode = true;
+          break;
         default:
           break;
       }
@@ -206,6 +206,34 @@ void minFilterTrivial(const lti::channel8 &src, lti::channel8 &dst, const int se
 }
 
 
+// Backend adapter for the verification mode (see morphOracle.h)
+void serialBackend(const grayBuffer &src, grayBuffer &dst, int se_size, morphOperation op)
+{
+  lti::channel8 in, out;
+  imageFromBuffer(src, in);
+  out.resize(in.rows(), in.columns(), 0);
+  if(op == MorphMin)
+    minFilterTrivial(in, out, se_size);
+  else
+    maxFilterTrivial(in, out, se_size);
+  bufferFromImage(out, dst);
+}
+
+
+/*
+ * SE sizes for the verification mode: the benchmark sizes plus the degenerate 1x1 and 3x3 cases
+ */
+vector<int> verifySizes()
+{
+  vector<int> sizes;
+  sizes.push_back(1);
+  sizes.push_back(3);
+  for(int i = 1; i < NUM_POINTS; i++)
+    sizes.push_back(i * MIN_KERNEL_SIZE);
+  return sizes;
+}
+
+
 double getVariance(vector<double> samples, double avg)
 {
   double result = 0.0;
@@ -224,6 +252,9 @@ int main(int argc, char* argv[])
   std::string imgFile;
   parseArgs(argc,argv,imgFile);
 
+  if(verifyMode)
+    return (runOracle("Serial", serialBackend, verifySizes()) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+
   lti::ioImage loader; // used to load an image file
 
   lti::image imgRgba;
@@ -244,6 +275,9 @@ int main(int argc, char* argv[])
   gray.resize(height, width, 0);
   gray.castFrom(imgRgba);
 
+  grayBuffer grayBuf, resultBuf;  // Input and output for the bit-exactness check
+  bufferFromImage(gray, grayBuf);
+
   #ifdef DISPLAY
   bool theEnd = false;
   lti::viewer2D view("Original Image");
@@ -269,18 +303,29 @@ int main(int argc, char* argv[])
     std::chrono::duration<double> diffA;
     double avgA = 0;
     vector<double> samplesA(NUM_TIME_IT);
+    allocReport allocsA;
     for(int j = 0; j < NUM_TIME_IT; j++)
     {
-      system("./clearCache.sh");
+      if(cacheMode == "cold")
+        system("./clearCache.sh");
+      allocScope allocA;
       auto startA = std::chrono::high_resolution_clock::now();
       minFilterTrivial(gray, minImg, i * MIN_KERNEL_SIZE);
       auto endA = std::chrono::high_resolution_clock::now();
+      allocsA = allocA.stop();
       diffA = endA - startA;
       samplesA[j] = diffA.count();
       avgA += (1.0 / NUM_TIME_IT) * diffA.count();
     }
-    finalTimes[i][0] = avgA;
-    cout << "Min Filter Variance = " << getVariance(samplesA, avgA) << endl << endl;
+    bufferFromImage(minImg, resultBuf);
+    bool exactA = bitExact(grayBuf, resultBuf, i * MIN_KERNEL_SIZE, MorphMin);
+    results.add("min", imgFile, width, height, i * MIN_KERNEL_SIZE, cacheMode, exactA, samplesA, allocsA);
+    cout << "Min Filter Variance = " << getVariance(samplesA, avgA) << endl;
+    printRoofline("Min Filter", width, height, NUM_PASSES, avgA);
+    printAllocs("Min Filter", allocsA);
+    if(!exactA)
+      cout << "WARNING: Min Filter output differs from the reference (run with -v for details)" << endl;
+    cout << endl;
 
     #ifdef DISPLAY
     lti::viewer2D view2("Min Image");
@@ -301,18 +346,29 @@ int main(int argc, char* argv[])
     std::chrono::duration<double> diffB;
     double avgB = 0;
     vector<double> samplesB(NUM_TIME_IT);
+    allocReport allocsB;
     for(int j = 0; j < NUM_TIME_IT; j++)
     {
-      system("./clearCache.sh");
+      if(cacheMode == "cold")
+        system("./clearCache.sh");
+      allocScope allocB;
       auto startB = std::chrono::high_resolution_clock::now();
       maxFilterTrivial(gray, maxImg, i * MIN_KERNEL_SIZE);
       auto endB = std::chrono::high_resolution_clock::now();
+      allocsB = allocB.stop();
       diffB = endB - startB;
       samplesB[j] = diffB.count();
       avgB += (1.0 / NUM_TIME_IT) * diffB.count();
     }
-    finalTimes[i][1] = avgB;
-    cout << "Max Filter Variance = " << getVariance(samplesB, avgB) << endl << endl;
+    bufferFromImage(maxImg, resultBuf);
+    bool exactB = bitExact(grayBuf, resultBuf, i * MIN_KERNEL_SIZE, MorphMax);
+    results.add("max", imgFile, width, height, i * MIN_KERNEL_SIZE, cacheMode, exactB, samplesB, allocsB);
+    cout << "Max Filter Variance = " << getVariance(samplesB, avgB) << endl;
+    printRoofline("Max Filter", width, height, NUM_PASSES, avgB);
+    printAllocs("Max Filter", allocsB);
+    if(!exactB)
+      cout << "WARNING: Max Filter output differs from the reference (run with -v for details)" << endl;
+    cout << endl;
 
     #ifdef DISPLAY
     lti::viewer2D view3("Max Image");
@@ -0,0 +1,165 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Tiled: out-of-core min/max filter for images larger than the RAM (satellite or wafer scans)
+*
+* The input (binary PGM, or raw 8-bit with -r) and the output PGM are memory-mapped and processed in row
+* bands with their SE halo (see ../Common/tiledMorph.h). The kernel is picked by the planner for the band
+* geometry, or forced with -k.
+**************************************************************************************************************/
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "morphDisk.h"
+#include "morphKernels.h"
+#include "morphPlanner.h"
+#include "tiledMorph.h"
+
+using namespace std;
+
+#define DEFAULT_SE_SIZE 5           // Default structuring element
+
+/*
+ * Help
+ */
+void usage()
+{
+  cout << "Usage: Tiled <input> <output.pgm> [-r rows cols] [-s se] [-o min|max] [-b rows] [-k kernel]" << endl;
+  cout << "       Tiled -g rows cols <output.pgm>" << endl;
+  cout << "  input   binary PGM (P5) image, or raw 8-bit pixels with -r." << endl;
+  cout << "  -r raw input of rows x cols pixels." << endl;
+  cout << "  -s structuring element size, default " << DEFAULT_SE_SIZE << "." << endl;
+  cout << "  -o operation, min (default) or max." << endl;
+  cout << "  -b rows per band, default " << TILE_BAND_ROWS << "." << endl;
+  cout << "  -k kernel (naive, separable, vanHerk, dokladal, transposed, neon), default chosen by the planner."
+       << endl;
+  cout << "     -k disk erodes or dilates a binary mask with the exact disk of radius (se - 1)/2." << endl;
+  cout << "  -g write a random rows x cols test image and exit." << endl;
+  cout << "  -h show this help." << endl;
+}
+
+// Random test image written band by band, so it can be larger than the RAM too
+int generate(int rows, int cols, const string &path)
+{
+  mappedImage out;
+  if(!out.create(path, rows, cols))
+  {
+    cerr << out.error() << endl;
+    return EXIT_FAILURE;
+  }
+  uint32_t state = 2463534242u;
+  for(int y = 0; y < rows; y++)
+  {
+    uint8_t *row = out.row(y);
+    for(int x = 0; x < cols; x++)
+      row[x] = oracleRandom(state) & 0xFF;
+    if((y + 1) % TILE_BAND_ROWS == 0 || y + 1 == rows)
+    {
+      int y0 = (y / TILE_BAND_ROWS) * TILE_BAND_ROWS;
+      out.flush(y0, y + 1);
+      out.release(y0, y + 1);
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+  vector<string> files;
+  int rawRows = 0, rawCols = 0;
+  int se = DEFAULT_SE_SIZE;
+  int bandRows = TILE_BAND_ROWS;
+  morphOperation op = MorphMin;
+  string kernel;
+  bool generateMode = false;
+
+  for(int i = 1; i < argc; i++)
+  {
+    string arg = argv[i];
+    if(arg == "-h")
+    {
+      usage();
+      return EXIT_SUCCESS;
+    }
+    else if((arg == "-r" || arg == "-g") && i + 2 < argc)
+    {
+      rawRows = atoi(argv[++i]);
+      rawCols = atoi(argv[++i]);
+      generateMode = (arg == "-g");
+    }
+    else if((arg == "-s" || arg == "-o" || arg == "-b" || arg == "-k") && i + 1 < argc)
+    {
+      string value = argv[++i];
+      if(arg == "-s")
+        se = atoi(value.c_str());
+      else if(arg == "-o")
+        op = (value == "max") ? MorphMax : MorphMin;
+      else if(arg == "-b")
+        bandRows = atoi(value.c_str());
+      else
+        kernel = value;
+    }
+    else
+      files.push_back(arg);
+  }
+
+  if(generateMode && files.size() == 1 && rawRows > 0 && rawCols > 0)
+    return generate(rawRows, rawCols, files[0]);
+  if(files.size() != 2 || se < 1 || bandRows < 1)
+  {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  mappedImage src, dst;
+  if(!src.openRead(files[0], rawRows, rawCols) || !dst.create(files[1], src.rows(), src.cols()))
+  {
+    cerr << (src.error().empty() ? dst.error() : src.error()) << endl;
+    return EXIT_FAILURE;
+  }
+
+  // The planner tunes on the band geometry, which is what the kernel actually sees
+  morphPlanner planner;
+  vector< pair<string, morphBackend> > kernels = morphKernels();
+  for(size_t k = 0; k < kernels.size(); k++)
+    planner.addCandidate(kernels[k].first, kernels[k].second);
+  int bandHeight = min(src.rows(), bandRows + se - 1);
+  if(kernel.empty())
+    kernel = planner.plan(planner.problem(bandHeight, src.cols(), se, op));
+
+  morphBackend backend;
+  if(kernel == "disk")
+    backend = morphDiskBackend;     // Not a planner candidate: the disk is not the square SE of the others
+  for(size_t k = 0; k < kernels.size(); k++)
+    if(kernels[k].first == kernel)
+      backend = kernels[k].second;
+  if(!backend)
+  {
+    cerr << "Unknown kernel " << kernel << endl;
+    return EXIT_FAILURE;
+  }
+
+  cout << morphName(op) << " filter, se=" << se << ", " << src.rows() << "x" << src.cols() << " pixels, "
+       << bandRows << " rows per band, kernel " << kernel << endl;
+  auto start = std::chrono::high_resolution_clock::now();
+  tiledStats stats = tiledMorph(src, dst, se, op, backend, bandRows);
+  dst.close();
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> diff = end - start;
+
+  struct rusage resources;
+  getrusage(RUSAGE_SELF, &resources);
+  cout << "Time = " << diff.count() << " s, " << stats.bands << " bands of up to " << stats.bandBytes
+       << " bytes, peak RSS = " << resources.ru_maxrss / 1024 << " MB" << endl;
+  return EXIT_SUCCESS;
+}
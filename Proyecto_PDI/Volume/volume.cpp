@@ -0,0 +1,232 @@
+/*************************************************************************************************************
+* Project: Optimization of DIP Operators with SIMD Instructions
+*
+* Digital Image Processing
+* Student: Ing. Juan Carlos Cruz Naranjo
+* Professor: Dr. Daniel Herrera Castro
+*
+* Volume: 3D min/max filter with a cuboid structuring element over CT or confocal stacks
+*
+* The stack is either a raw 8-bit volume (slice after slice, mapped from disk) or a directory of binary PGM
+* slices. Slices are streamed through the x, y and z passes of ../Common/morph3D.h, so only about twice the
+* SE depth in slices is resident, whatever the depth of the stack.
+**************************************************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/resource.h>
+
+#include "grayIngest.h"
+#include "morph3D.h"
+#include "morphOracle.h"
+
+using namespace std;
+
+#define DEFAULT_SE_SIZE 3           // Default structuring element on every axis
+
+/*
+ * Help
+ */
+void usage()
+{
+  cout << "Usage: Volume <input> <output> [-r slices rows cols] [-s x y z] [-o min|max]" << endl;
+  cout << "       Volume -g slices rows cols <output>" << endl;
+  cout << "  input   directory of binary PGM slices (sorted by name), written to the output" << endl;
+  cout << "          directory as slice_NNNN.pgm; or a raw 8-bit volume with -r, written raw." << endl;
+  cout << "  -r raw input of slices x rows x cols voxels." << endl;
+  cout << "  -s structuring element in x, y and z, default " << DEFAULT_SE_SIZE << " on every axis." << endl;
+  cout << "  -o operation, min (default) or max." << endl;
+  cout << "  -g write a random raw volume and exit." << endl;
+  cout << "  -h show this help." << endl;
+}
+
+// Sorted binary PGM files of a directory
+vector<string> sliceFiles(const string &dirPath)
+{
+  vector<string> files;
+  DIR *dir = opendir(dirPath.c_str());
+  if(dir == NULL)
+    return files;
+  for(struct dirent *entry = readdir(dir); entry != NULL; entry = readdir(dir))
+    if(entry->d_name[0] != '.' && isPgmFile(entry->d_name))
+      files.push_back(dirPath + "/" + entry->d_name);
+  closedir(dir);
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+// Rows [z * rows, (z + 1) * rows) of a mapped volume as one slice
+grayView sliceView(const mappedImage &volume, int z, int rows)
+{
+  grayView v = { volume.row(z * rows), rows, volume.cols(), volume.cols() };
+  return v;
+}
+
+int generate(int slices, int rows, int cols, const string &path)
+{
+  mappedImage out;
+  if(!out.create(path, slices * rows, cols, false))
+  {
+    cerr << out.error() << endl;
+    return EXIT_FAILURE;
+  }
+  uint32_t state = 2463534242u;
+  for(int z = 0; z < slices; z++)
+  {
+    for(int y = z * rows; y < (z + 1) * rows; y++)
+      for(int x = 0; x < cols; x++)
+        out.row(y)[x] = oracleRandom(state) & 0xFF;
+    out.flush(z * rows, (z + 1) * rows);
+    out.release(z * rows, (z + 1) * rows);
+  }
+  return EXIT_SUCCESS;
+}
+
+// Raw volume in, raw volume out
+int filterRaw(const string &input, const string &output, int slices, int rows, int cols, int se[3],
+              morphOperation op)
+{
+  mappedImage src, dst;
+  if(!src.openRead(input, slices * rows, cols) || !dst.create(output, slices * rows, cols, false))
+  {
+    cerr << (src.error().empty() ? dst.error() : src.error()) << endl;
+    return EXIT_FAILURE;
+  }
+
+  morph3D filter;
+  int z = 0;
+  auto write = [&]()
+  {
+    std::copy(filter.output().pixels.begin(), filter.output().pixels.end(), dst.row(z * rows));
+    dst.flush(z * rows, (z + 1) * rows);
+    dst.release(z * rows, (z + 1) * rows);
+    z++;
+  };
+
+  filter.begin(rows, cols, se[0], se[1], se[2], op);
+  for(int s = 0; s < slices; s++)
+  {
+    bool ready = filter.push(sliceView(src, s, rows));
+    src.release(s * rows, (s + 1) * rows);      // The filter keeps its own copy of what it still needs
+    if(ready)
+      write();
+  }
+  while(filter.finish())
+    write();
+  return EXIT_SUCCESS;
+}
+
+// Directory of PGM slices in, directory of PGM slices out
+int filterSlices(const string &input, const string &output, int se[3], morphOperation op)
+{
+  vector<string> files = sliceFiles(input);
+  if(files.empty())
+  {
+    cerr << "No binary PGM slices in " << input << endl;
+    return EXIT_FAILURE;
+  }
+
+  morph3D filter;
+  int rows = 0, cols = 0, z = 0;
+  auto write = [&]()
+  {
+    char name[32];
+    snprintf(name, sizeof(name), "/slice_%04d.pgm", z++);
+    mappedImage out;
+    if(!out.create(output + name, rows, cols))
+    {
+      cerr << out.error() << endl;
+      return false;
+    }
+    const grayBuffer &result = filter.output();
+    for(int y = 0; y < rows; y++)
+      std::copy(result[y], result[y] + cols, out.row(y));
+    return true;
+  };
+
+  for(size_t s = 0; s < files.size(); s++)
+  {
+    grayInput slice;
+    if(!slice.open(files[s], NULL))
+    {
+      cerr << slice.error() << endl;
+      return EXIT_FAILURE;
+    }
+    if(s == 0)
+    {
+      rows = slice.rows();
+      cols = slice.cols();
+      filter.begin(rows, cols, se[0], se[1], se[2], op);
+    }
+    else if(slice.rows() != rows || slice.cols() != cols)
+    {
+      cerr << files[s] << " is not " << rows << "x" << cols << " like the first slice" << endl;
+      return EXIT_FAILURE;
+    }
+
+    if(filter.push(slice.view()) && !write())
+      return EXIT_FAILURE;
+  }
+  while(filter.finish())
+    if(!write())
+      return EXIT_FAILURE;
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+  vector<string> files;
+  int size[3] = { 0, 0, 0 };        // slices, rows, cols of a raw volume
+  int se[3] = { DEFAULT_SE_SIZE, DEFAULT_SE_SIZE, DEFAULT_SE_SIZE };
+  morphOperation op = MorphMin;
+  bool generateMode = false;
+
+  for(int i = 1; i < argc; i++)
+  {
+    string arg = argv[i];
+    if(arg == "-h")
+    {
+      usage();
+      return EXIT_SUCCESS;
+    }
+    else if((arg == "-r" || arg == "-g" || arg == "-s") && i + 3 < argc)
+    {
+      int *values = (arg == "-s") ? se : size;
+      for(int v = 0; v < 3; v++)
+        values[v] = atoi(argv[++i]);
+      generateMode = generateMode || (arg == "-g");
+    }
+    else if(arg == "-o" && i + 1 < argc)
+      op = (string(argv[++i]) == "max") ? MorphMax : MorphMin;
+    else
+      files.push_back(arg);
+  }
+
+  bool raw = size[0] > 0 && size[1] > 0 && size[2] > 0;
+  if(generateMode && raw && files.size() == 1)
+    return generate(size[0], size[1], size[2], files[0]);
+  if(generateMode || files.size() != 2 || se[0] < 1 || se[1] < 1 || se[2] < 1)
+  {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  cout << morphName(op) << " filter, se=" << se[0] << "x" << se[1] << "x" << se[2] << endl;
+  auto start = std::chrono::high_resolution_clock::now();
+  int status = raw ? filterRaw(files[0], files[1], size[0], size[1], size[2], se, op)
+                   : filterSlices(files[0], files[1], se, op);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> diff = end - start;
+
+  struct rusage resources;
+  getrusage(RUSAGE_SELF, &resources);
+  cout << "Time = " << diff.count() << " s, peak RSS = " << resources.ru_maxrss / 1024 << " MB" << endl;
+  return status;
+}
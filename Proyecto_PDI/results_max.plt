@@ -1,7 +1,14 @@
 #!/usr/bin/gnuplot -persist
 
+# Reads the data.csv file written by each version:
+# backend,operation,se_size,width,height,cache_mode,mean_ms,min_ms,variance_ms2,bit_exact,
+# passes,gbps,pixels_per_cycle,roofline_pct,allocations,alloc_bytes,peak_heap_bytes,peak_rss_delta_kb,
+# image,samples_ms
+if (!exists("VERSIONS")) VERSIONS = "LTI-Lib2 Neon-Vectorial OpenCV Paper Planner Serial"
+
+set datafile separator ","
 set title "Max FilterTiming Results"
 set xlabel "Kernel Size"
 set ylabel "Time (ms)"
 set grid
-plot "data_max.dat" u (column(0)):2:xtic(1) w l title "LTI-Lib2", "data_max.dat" u (column(0)):3:xtic(1) w l title "OpenCV", "data_max.dat" u (column(0)):4:xtic(1) w l title "Paper", "data_max.dat" u (column(0)):5:xtic(1) w l title "Serial"
+plot for [v in VERSIONS] v."/data.csv" u 3:(strcol(2) eq "max" ? $7 : NaN) w lp title v
@@ -0,0 +1,12 @@
+#!/usr/bin/gnuplot -persist
+
+# Percentage of the STREAM triad bandwidth reached by each version (column roofline_pct of data.csv)
+if (!exists("VERSIONS")) VERSIONS = "LTI-Lib2 Neon-Vectorial OpenCV Paper Planner Serial"
+
+set datafile separator ","
+set title "Roofline: Achieved Bandwidth (Min and Max Filters)"
+set xlabel "Kernel Size"
+set ylabel "% of STREAM Triad Bandwidth"
+set grid
+plot for [v in VERSIONS] v."/data.csv" u 3:(strcol(2) eq "min" ? $14 : NaN) w lp title v." min", \
+     for [v in VERSIONS] v."/data.csv" u 3:(strcol(2) eq "max" ? $14 : NaN) w lp dt 2 title v." max"